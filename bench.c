@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <starpu.h>
+
+#include "mandelbrot.h"
+
+/* Upper bound on the number of values accepted in a -w/-h/-i sweep list. */
+#define MAX_SWEEP 32
+
+/**
+ * @brief Prints the command-line usage of the benchmark on stderr.
+ *
+ * @param name The program name, as found in `argv[0]`.
+ */
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [-w cols[,cols...]] [-h rows[,rows...]] [-i iter[,iter...]] [-r repetitions]\n",
+            name);
+}
+
+/**
+ * @brief Parses a comma-separated list of positive integers.
+ *
+ * @param arg The option argument, e.g. "1024,4096".
+ * @param values Receives the parsed values.
+ * @param max The capacity of `values`.
+ * @return int The number of values parsed, or -1 if a value is invalid or the
+ *         list is too long.
+ */
+int parse_list(char *arg, unsigned *values, int max) {
+    int n = 0;
+    for (char *tok = strtok(arg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        if (n == max || atoi(tok) <= 0) {
+            return -1;
+        }
+        values[n++] = atoi(tok);
+    }
+    return n;
+}
+
+/**
+ * @brief Returns the average busy fraction of the StarPU workers since profiling was reset.
+ *
+ * Reads the per-worker profiling counters and averages `executing_time / total_time`
+ * over all workers, which shows how well the scheduler kept the machine saturated
+ * during the frame (1.0 means no worker ever idled).
+ *
+ * @return double The mean worker utilization in 0..1, or 0 if no data is available.
+ */
+double worker_utilization(void) {
+    unsigned nworkers = starpu_worker_get_count();
+    double sum = 0.0;
+    unsigned counted = 0;
+
+    for (unsigned w = 0; w < nworkers; w++) {
+        struct starpu_profiling_worker_info info;
+        if (starpu_profiling_worker_get_info(w, &info) != 0) {
+            continue;
+        }
+        double total = starpu_timing_timespec_to_us(&info.total_time);
+        double executing = starpu_timing_timespec_to_us(&info.executing_time);
+        if (total > 0.0) {
+            sum += executing / total;
+            counted++;
+        }
+    }
+    return counted > 0 ? sum / counted : 0.0;
+}
+
+/**
+ * @brief Benchmark harness: renders resolution/iteration sweeps and reports per-stage timings.
+ *
+ * For every combination of the requested grid sizes and iteration budgets (and for each
+ * repetition) the harness renders one frame of the default viewport and measures each
+ * stage separately: task submission (`submit_frame`), computation
+ * (`starpu_task_wait_for_all` inside `finish_frame`), and output conversion
+ * (`write_pgm` to /dev/null). StarPU profiling is re-armed before every frame (the
+ * enable resets the worker counters), so each row's mean worker utilization covers
+ * just that frame's compute stage.
+ *
+ * Results are emitted as one CSV row per run on stdout, with a header line first, so
+ * CI dashboards can ingest the numbers directly:
+ *
+ *     cols,rows,iter,tasks,submit_ms,compute_ms,write_ms,tasks_per_sec,pixels_per_sec,worker_util
+ *
+ * @param argc The argument count.
+ * @param argv The argument vector; see `usage` for the accepted options.
+ * @return int Returns 0 on success, 1 if an allocation fails, or 2 if the command
+ *         line is invalid.
+ */
+int main(int argc, char *argv[]) {
+    unsigned cols_list[MAX_SWEEP] = {1024};
+    unsigned rows_list[MAX_SWEEP] = {1024};
+    unsigned iter_list[MAX_SWEEP] = {2000};
+    int ncols = 1, nrows = 1, niter = 1, reps = 3;
+
+    int c;
+    while ((c = getopt(argc, argv, "w:h:i:r:")) != -1) {
+        switch (c) {
+        case 'w':
+            ncols = parse_list(optarg, cols_list, MAX_SWEEP);
+            break;
+        case 'h':
+            nrows = parse_list(optarg, rows_list, MAX_SWEEP);
+            break;
+        case 'i':
+            niter = parse_list(optarg, iter_list, MAX_SWEEP);
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (ncols < 1 || nrows < 1 || niter < 1 || reps < 1 || nrows != ncols) {
+        if (nrows != ncols) {
+            fprintf(stderr, "-w and -h must list the same number of sizes\n");
+        }
+        usage(argv[0]);
+        return 2;
+    }
+
+    starpu_init(NULL);
+    select_cpu_kernel();
+    starpu_profiling_status_set(STARPU_PROFILING_ENABLE);
+
+    printf("cols,rows,iter,tasks,submit_ms,compute_ms,write_ms,tasks_per_sec,pixels_per_sec,worker_util\n");
+
+    for (int s = 0; s < ncols; s++) {
+        unsigned rows = rows_list[s];
+        unsigned cols = cols_list[s];
+
+        size_t mask_size = (size_t)rows * cols * sizeof(uint32_t);
+        uint32_t *mask = mb_alloc(mask_size);
+        if (mask == NULL) {
+            perror("starpu_malloc");
+            starpu_shutdown();
+            return 1;
+        }
+        starpu_data_handle_t mask_handle;
+        starpu_matrix_data_register(&mask_handle, STARPU_MAIN_RAM, (uintptr_t)mask,
+                                    cols, cols, rows, sizeof(uint32_t));
+
+        for (int it = 0; it < niter; it++) {
+            int iter = iter_list[it];
+            struct viewport view = viewport_centered(-0.75, 0.0, 1.0, rows, cols);
+
+            for (int rep = 0; rep < reps; rep++) {
+                // Re-enabling profiling resets the worker counters, so the
+                // utilization column covers exactly this frame's compute stage
+                // instead of everything accumulated since program start.
+                starpu_profiling_status_set(STARPU_PROFILING_ENABLE);
+                double t0 = starpu_timing_now();
+                unsigned tasks = submit_frame(mask_handle, rows, cols, &view, iter);
+                double t1 = starpu_timing_now();
+                finish_frame(mask_handle);
+                double t2 = starpu_timing_now();
+                // Sampled before the write stage, where the workers sit idle.
+                double util = worker_utilization();
+                write_pgm("/dev/null", mask, rows, cols, iter);
+                double t3 = starpu_timing_now();
+
+                double submit_ms = (t1 - t0) / 1000.0;
+                double compute_ms = (t2 - t1) / 1000.0;
+                double write_ms = (t3 - t2) / 1000.0;
+                double frame_s = (t2 - t0) / 1e6;
+                printf("%u,%u,%d,%u,%.3f,%.3f,%.3f,%.0f,%.0f,%.3f\n",
+                       cols, rows, iter, tasks, submit_ms, compute_ms, write_ms,
+                       tasks / frame_s, (double)rows * cols / frame_s, util);
+            }
+        }
+
+        starpu_data_unregister(mask_handle);
+        mb_free(mask, mask_size);
+    }
+
+    starpu_shutdown();
+    return 0;
+}
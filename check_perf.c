@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex.h>
+#include <starpu.h>
+
+#include "mandelbrot.h"
+
+/*
+ * Kernel-level correctness and throughput suite (`make check-perf`). The
+ * end-to-end harness (`mandelbrot-bench`) measures whole frames through the
+ * scheduler; this one drives every CPU tile kernel of the build directly on a
+ * fabricated tile interface, checks its output against the reference scalar
+ * kernel and a set of hand-derived escape counts, and measures per-kernel
+ * throughput at several iteration budgets against a recorded baseline — so a
+ * regression in one kernel is caught by name instead of disappearing into a
+ * frame-level average.
+ */
+
+/* Iteration budgets the throughput of each kernel is measured at. */
+static const int sweep_iter[] = { 100, 1000, 10000 };
+
+/* Minimum measurement time per kernel/budget pair, in microseconds. */
+#define MEASURE_US 100000.0
+
+/* A kernel fails the regression check below this fraction of its baseline. */
+#define REGRESS_FRAC 0.8
+
+/* Baseline file, one "kernel iter points-per-second" line per measurement. */
+#define BASELINE_PATH "check-perf.baseline"
+
+/*
+ * Escape-count oracle: points whose counts follow from a few lines of algebra,
+ * independent of the implementation. The interior points cover the cardioid and
+ * period-2 bulb prechecks, the boundary point c = -2 the periodicity detection
+ * (its orbit is fixed at 2 and never exceeds the escape radius).
+ */
+#define ORACLE_ITER 1000
+static const struct {
+    double cr, ci;
+    uint32_t expect;
+} oracle[] = {
+    { 0.0, 0.0, ORACLE_ITER },  /* cardioid center, never escapes */
+    { 0.25, 0.0, ORACLE_ITER }, /* cardioid cusp, interior by precheck */
+    { -1.0, 0.0, ORACLE_ITER }, /* period-2 bulb center */
+    { -2.0, 0.0, ORACLE_ITER }, /* orbit fixed at 2, caught by periodicity */
+    { 1.0, 0.0, 2 },            /* z: 0, 1, 2, 5 — escapes at the third step */
+    { 2.0, 0.0, 1 },            /* z: 0, 2, 6 — escapes at the second step */
+    { 0.0, 2.0, 1 },            /* z: 0, 2i, -4+2i — escapes at the second step */
+};
+
+/**
+ * @brief Builds the matrix interface of a standalone `TILE_ROWS x TILE_COLS` tile.
+ *
+ * The kernels read only the interface fields, so a tile fabricated on a plain
+ * buffer drives them without registering any handle; with the zeroed descriptor
+ * position the tile sits at the frame origin and the viewport describes its
+ * region.
+ *
+ * @param buf The tile buffer, `TILE_ROWS * TILE_COLS` elements.
+ * @return struct starpu_matrix_interface The interface handed to the kernels.
+ */
+static struct starpu_matrix_interface tile_interface(uint32_t *buf) {
+    struct starpu_matrix_interface m;
+    memset(&m, 0, sizeof(m));
+    m.ptr = (uintptr_t)buf;
+    m.dev_handle = (uintptr_t)buf;
+    m.nx = TILE_COLS;
+    m.ny = TILE_ROWS;
+    m.ld = TILE_COLS;
+    m.elemsize = sizeof(uint32_t);
+    return m;
+}
+
+/**
+ * @brief Renders one tile with the given kernel.
+ *
+ * @param func The kernel under test.
+ * @param buf The tile buffer to render into.
+ * @param view The viewport describing the tile's region.
+ * @param iter The iteration budget.
+ */
+static void run_kernel(void (*func)(void *buffers[], void *cl_arg),
+                       uint32_t *buf, const struct viewport *view, int iter) {
+    struct starpu_matrix_interface tile = tile_interface(buf);
+    void *buffers[1] = { &tile };
+    struct tile_args args;
+    memset(&args, 0, sizeof(args));
+    args.view = *view;
+    args.iter = iter;
+    func(buffers, &args);
+}
+
+/**
+ * @brief Checks a kernel's tile against the reference, with per-kernel tolerances.
+ *
+ * The SIMD kernels claim bit-identical results and get no slack. The precision
+ * variants legitimately differ on boundary pixels (different rounding of the
+ * same orbit), the adaptive kernel carries the documented iso-band approximation
+ * on exterior counts, so each is allowed a small fraction of differing pixels.
+ * The smooth kernel is compared on the integer part of its fixed-point values
+ * (the fraction redistributes up to two counts around the escape step), and the
+ * coarse kernel only at the pixels it actually samples.
+ *
+ * @param name The kernel's inventory name.
+ * @param val The tile rendered by the kernel under test.
+ * @param ref The tile rendered by the reference scalar kernel.
+ * @return int Returns 0 when the tile is acceptable, -1 otherwise.
+ */
+static int check_tile(const char *name, const uint32_t *val, const uint32_t *ref) {
+    double slack = 0.0; /* tolerated fraction of differing pixels */
+    unsigned stride = 1;
+
+    if (strcmp(name, "f32") == 0 || strcmp(name, "f80") == 0) {
+        slack = 0.02;
+    } else if (strcmp(name, "adaptive") == 0) {
+        slack = 0.05;
+    } else if (strcmp(name, "coarse") == 0) {
+        stride = 8; /* only the sampled grid is computed exactly */
+    }
+
+    unsigned checked = 0, bad = 0;
+    for (unsigned i = 0; i < TILE_ROWS; i += stride) {
+        for (unsigned j = 0; j < TILE_COLS; j += stride) {
+            uint32_t v = val[i * TILE_COLS + j];
+            uint32_t r = ref[i * TILE_COLS + j];
+            if (strcmp(name, "smooth") == 0) {
+                uint32_t n = v >> SMOOTH_BITS;
+                bad += n > r + 2 || n + 2 < r;
+            } else {
+                bad += v != r;
+            }
+            checked++;
+        }
+    }
+    if ((double)bad > slack * (double)checked) {
+        fprintf(stderr, "FAIL %s: %u of %u pixels differ from the reference\n",
+                name, bad, checked);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Measures a kernel's throughput on one tile at one iteration budget.
+ *
+ * The tile is rendered repeatedly until `MEASURE_US` of wall time has
+ * accumulated, so fast kernels are averaged over many repetitions and slow ones
+ * still finish in bounded time.
+ *
+ * @param func The kernel under test.
+ * @param buf The tile buffer to render into.
+ * @param view The viewport describing the tile's region.
+ * @param iter The iteration budget.
+ * @return double The measured throughput in points per second.
+ */
+static double measure_kernel(void (*func)(void *buffers[], void *cl_arg),
+                             uint32_t *buf, const struct viewport *view, int iter) {
+    double start = starpu_timing_now();
+    double elapsed;
+    unsigned reps = 0;
+    do {
+        run_kernel(func, buf, view, iter);
+        reps++;
+        elapsed = starpu_timing_now() - start;
+    } while (elapsed < MEASURE_US);
+    return (double)reps * TILE_ROWS * TILE_COLS / (elapsed * 1e-6);
+}
+
+/**
+ * @brief Looks up a measurement in the baseline file contents.
+ *
+ * @param baseline The baseline file contents, or NULL when the file is absent.
+ * @param name The kernel's inventory name.
+ * @param iter The iteration budget.
+ * @return double The recorded points per second, or 0 when not recorded.
+ */
+static double baseline_lookup(const char *baseline, const char *name, int iter) {
+    if (baseline == NULL) {
+        return 0.0;
+    }
+    char key[64];
+    snprintf(key, sizeof(key), "%s %d ", name, iter);
+    for (const char *line = baseline; line != NULL; line = strchr(line, '\n')) {
+        line += *line == '\n';
+        if (strncmp(line, key, strlen(key)) == 0) {
+            return atof(line + strlen(key));
+        }
+    }
+    return 0.0;
+}
+
+/**
+ * @brief Runs the correctness checks and the throughput regression sweep.
+ *
+ * Exits non-zero when any kernel produces wrong results or falls below
+ * `REGRESS_FRAC` of its recorded baseline. Without a baseline (first run, or a
+ * new kernel) the measured numbers are recorded and the run passes — commit the
+ * baseline produced on the reference machine to make the threshold meaningful.
+ */
+int main(void) {
+    if (starpu_init(NULL) != 0) {
+        fprintf(stderr, "starpu_init failed\n");
+        return 1;
+    }
+
+    int failed = 0;
+
+    // Correctness against the hand-derived oracle, reference kernel first.
+    for (size_t p = 0; p < sizeof(oracle) / sizeof(oracle[0]); p++) {
+        uint32_t got = (uint32_t)escape_time(oracle[p].cr + oracle[p].ci * I, ORACLE_ITER);
+        if (got != oracle[p].expect) {
+            fprintf(stderr, "FAIL escape_time(%g, %g): got %u, expected %u\n",
+                    oracle[p].cr, oracle[p].ci, got, oracle[p].expect);
+            failed = 1;
+        }
+    }
+
+    // One tile over the whole set: mixed interior, exterior and boundary pixels.
+    struct viewport view = viewport_centered(-0.75, 0.0, 1.0, TILE_ROWS, TILE_COLS);
+    uint32_t *ref = mb_alloc(TILE_ROWS * TILE_COLS * sizeof(uint32_t));
+    uint32_t *val = mb_alloc(TILE_ROWS * TILE_COLS * sizeof(uint32_t));
+    if (ref == NULL || val == NULL) {
+        perror("starpu_malloc");
+        starpu_shutdown();
+        return 1;
+    }
+
+    unsigned nkernels;
+    const struct cpu_kernel *kernels = cpu_kernels(&nkernels);
+
+    run_kernel(kernels[0].func, ref, &view, ORACLE_ITER); // "scalar", the reference
+    for (unsigned k = 1; k < nkernels; k++) {
+        run_kernel(kernels[k].func, val, &view, ORACLE_ITER);
+        if (check_tile(kernels[k].name, val, ref) < 0) {
+            failed = 1;
+        }
+    }
+
+    // Throughput sweep against the recorded baseline.
+    char *baseline = NULL;
+    FILE *f = fopen(BASELINE_PATH, "r");
+    if (f != NULL) {
+        fseek(f, 0, SEEK_END);
+        long len = ftell(f);
+        rewind(f);
+        baseline = malloc((size_t)len + 1);
+        if (baseline != NULL && fread(baseline, 1, (size_t)len, f) == (size_t)len) {
+            baseline[len] = '\0';
+        } else {
+            free(baseline);
+            baseline = NULL;
+        }
+        fclose(f);
+    }
+
+    int incomplete = 0;
+    printf("kernel,iter,points/sec,baseline,status\n");
+    for (unsigned k = 0; k < nkernels; k++) {
+        for (size_t s = 0; s < sizeof(sweep_iter) / sizeof(sweep_iter[0]); s++) {
+            double pps = measure_kernel(kernels[k].func, val, &view, sweep_iter[s]);
+            double base = baseline_lookup(baseline, kernels[k].name, sweep_iter[s]);
+            const char *status = "ok";
+            if (base == 0.0) {
+                status = "recorded";
+                incomplete = 1;
+                FILE *out = fopen(BASELINE_PATH, "a");
+                if (out != NULL) {
+                    fprintf(out, "%s %d %.0f\n", kernels[k].name, sweep_iter[s], pps);
+                    fclose(out);
+                }
+            } else if (pps < REGRESS_FRAC * base) {
+                status = "REGRESSION";
+                failed = 1;
+            }
+            printf("%s,%d,%.0f,%.0f,%s\n", kernels[k].name, sweep_iter[s], pps, base, status);
+        }
+    }
+    if (incomplete) {
+        fprintf(stderr, "note: baseline entries recorded in %s; re-run to enforce them\n",
+                BASELINE_PATH);
+    }
+
+    free(baseline);
+    mb_free(ref, TILE_ROWS * TILE_COLS * sizeof(uint32_t));
+    mb_free(val, TILE_ROWS * TILE_COLS * sizeof(uint32_t));
+    starpu_shutdown();
+    return failed;
+}
@@ -1,140 +1,294 @@
 #include <stdio.h>
-#include <complex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
 #include <starpu.h>
 
-#define ROWS 63
-#define COLS 100
-#define ITER 2000
+#include "mandelbrot.h"
+
+/*
+ * Default rendering parameters, used when the corresponding command-line option is
+ * not given. The default viewport is centered on (-0.75, 0) and spans 2.5 along the
+ * real axis and 3.0 along the imaginary axis at zoom 1, which reproduces the classic
+ * -2.0..0.5 x -1.5..1.5 view of the set.
+ */
+#define DEFAULT_ROWS 63
+#define DEFAULT_COLS 100
+#define DEFAULT_ITER 2000
+#define DEFAULT_CENTER_REAL -0.75
+#define DEFAULT_CENTER_IMAG 0.0
 
 /**
- * @brief Determines if a complex number remains stable under iteration of the Mandelbrot function.
- *
- * This function iterates the Mandelbrot equation: `z = z^2 + c`, starting with `z = 0`
- * for a given complex number `c`. After the specified number of iterations, it checks if
- * the magnitude (absolute value) of the resulting complex number `z` is less than or equal
- * to 2. If the magnitude exceeds 2 at any point, the sequence is considered unstable.
+ * @brief Rendering parameters collected from the command line.
  *
- * @param c The complex number to test for stability.
- * @param iter The number of iterations to apply the Mandelbrot function.
- * @return int Returns 1 if the complex number is stable (i.e., its magnitude is <= 2 after the iterations),
- *         or 0 if it is unstable (magnitude exceeds 2).
+ * `rows` and `cols` give the resolution of the output grid, `iter` the maximum number
+ * of Mandelbrot iterations per point, and `center_real`/`center_imag`/`zoom` select the
+ * viewport: the frame is centered on the given complex number and covers
+ * `BASE_REAL_SPAN / zoom` along the real axis and `BASE_IMAG_SPAN / zoom` along the
+ * imaginary axis. When `frames` is greater than 1 the program renders a zoom
+ * animation: the same center is kept and the zoom is multiplied by `zoom_step`
+ * between consecutive frames, with StarPU and the data handles staying alive for
+ * the whole sequence.
  */
-int is_stable(double complex c, int iter) {
-	double complex z = 0;
-	for (int i = 0; i < iter; i++) {
-		z = z * z + c;
-	}
-	return cabs(z) <= (double) 2.0;
-}
+struct options {
+    unsigned rows;
+    unsigned cols;
+    int iter;
+    double center_real;
+    double center_imag;
+    double zoom;
+    const char *output; /* output file, or NULL for the ASCII chart */
+    unsigned frames;    /* number of animation frames to render */
+    double zoom_step;   /* zoom multiplier applied between frames */
+    int adaptive;       /* use the Mariani-Silver adaptive tile kernel */
+    int ssaa;           /* supersample boundary pixels for anti-aliasing */
+    int smooth;         /* emit 24.8 fixed-point smooth escape values */
+    int progressive;    /* Z-order submission with a coarse preview pass */
+    const char *histogram; /* histogram CSV file, or NULL to skip statistics */
+    long pan_x;         /* pan applied between frames, in pixels */
+    long pan_y;
+};
 
 /**
- * @brief Fills an array with complex numbers representing a grid in the complex plane.
- *
- * This function generates a grid of complex numbers over a specified range of real and
- * imaginary components. The real part ranges from -2.0 to 0.5, and the imaginary part
- * ranges from -1.5 to 1.5. The array is filled such that each element corresponds to
- * a point on the grid defined by the `ROWS` and `COLS` constants, representing the
- * dimensions of the complex plane.
+ * @brief One frame handed to the writer thread.
+ */
+struct writer_job {
+    char path[4096];      /* output file; unused when `print` is set */
+    const uint32_t *mask; /* the frame's escape-time surface */
+    unsigned rows;
+    unsigned cols;
+    int iter;
+    int print;            /* print_chart to the terminal instead of write_output */
+};
+
+/*
+ * Writer thread state: a one-slot mailbox. The render loop blocks in
+ * `writer_submit` only when the writer is still busy with the previous frame,
+ * so per-frame wall time is max(render, write) instead of their sum.
+ */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct writer_job job;
+    int pending;
+    int stop;
+    int failed;
+} writer = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * @brief Writer thread: writes frames handed over by the render loop.
  *
- * @param array A pointer to the array where the complex numbers will be stored. The array
- *        should have a size of `ROWS * COLS`.
+ * Runs until `writer_finish` signals the end of the animation. Output failures are
+ * recorded in `writer.failed` rather than aborting, so the render loop keeps its
+ * simple structure and the error surfaces in the exit code.
  *
- * @note The filled array is typically used as input to check the stability of each complex number
- *       for the Mandelbrot set, determining whether each point lies within the set based on
- *       iterative calculations.
+ * @param arg Unused.
+ * @return void* Always NULL.
  */
-void fill_array(double complex* array) {
-	double real_start = -2.0;
-	double real_end = 0.5;
-	double imag_start = -1.5;
-	double imag_end = 1.5;
-
-	// Determine the step for real and imaginary components
-	double real_step = (real_end - real_start) / (COLS - 1);
-	double imag_step = (imag_end - imag_start) / (ROWS - 1);
-
-    // Fill the array with complex numbers
-	for (int i = 0; i < ROWS; i++) {
-		for (int j = 0; j < COLS; j++) {
-			double real_part = real_start + j * real_step;
-			double imag_part = imag_start + i * imag_step;
-            array[i * COLS + j] = real_part + imag_part * I;
-		}
-	}
+static void *writer_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&writer.lock);
+    for (;;) {
+        while (!writer.pending && !writer.stop) {
+            pthread_cond_wait(&writer.cond, &writer.lock);
+        }
+        if (!writer.pending) {
+            break;
+        }
+        struct writer_job job = writer.job;
+        pthread_mutex_unlock(&writer.lock);
+
+        int rc = 0;
+        if (job.print) {
+            print_chart((uint32_t *)job.mask, job.rows, job.cols, job.iter);
+        } else {
+            rc = write_output(job.path, job.mask, job.rows, job.cols, job.iter);
+        }
+
+        pthread_mutex_lock(&writer.lock);
+        if (rc < 0) {
+            writer.failed = 1;
+        }
+        writer.pending = 0;
+        pthread_cond_broadcast(&writer.cond);
+    }
+    pthread_mutex_unlock(&writer.lock);
+    return NULL;
 }
 
 /**
- * @brief Prints a simple ASCII chart representing the Mandelbrot set.
+ * @brief Hands a completed frame to the writer thread.
  *
- * This function takes an array of integers that represent the results of Mandelbrot
- * set calculations and prints a visual representation of the set using ASCII characters.
- * Each element in the array corresponds to a point on a 2D grid, where `1` indicates
- * that the corresponding complex number is part of the Mandelbrot set (or within a stable
- * boundary), and `0` indicates that it is outside the set.
+ * Blocks while the writer is still busy with the previous frame; on return the new
+ * frame is queued and the writer works on it concurrently with the next render.
  *
- * The function prints a `.` character for stable points (value `1`), representing points
- * that belong to the Mandelbrot set, and a space (` `) for unstable points (value `0`),
- * representing points outside the set.
+ * @param job The frame to write.
+ */
+static void writer_submit(const struct writer_job *job) {
+    pthread_mutex_lock(&writer.lock);
+    while (writer.pending) {
+        pthread_cond_wait(&writer.cond, &writer.lock);
+    }
+    writer.job = *job;
+    writer.pending = 1;
+    pthread_cond_broadcast(&writer.cond);
+    pthread_mutex_unlock(&writer.lock);
+}
+
+/**
+ * @brief Drains the writer thread and reports whether any frame failed to write.
  *
- * @param array A pointer to an integer array that contains the Mandelbrot set results.
- *        The array should be of size `ROWS * COLS`, where each element corresponds to a
- *        point on the complex plane grid.
+ * @param thread The writer thread started with `writer_main`.
+ * @return int Returns 0 if every frame was written, -1 otherwise.
+ */
+static int writer_finish(pthread_t thread) {
+    pthread_mutex_lock(&writer.lock);
+    writer.stop = 1;
+    pthread_cond_broadcast(&writer.cond);
+    pthread_mutex_unlock(&writer.lock);
+    pthread_join(thread, NULL);
+    return writer.failed ? -1 : 0;
+}
+
+/*
+ * Progress meter state (-p). The tile completion callback fires on StarPU worker
+ * threads, so the counter is atomic; the meter is redrawn only when the integer
+ * percentage changes, which keeps the stderr traffic negligible.
+ */
+static unsigned progress_total;
+static unsigned progress_count;
+
+/**
+ * @brief Tile completion callback: redraws the per-frame progress meter on stderr.
  *
- * @note This function provides a very basic ASCII visualization of the Mandelbrot set
- *       in a terminal or console. Each line printed corresponds to a row of points in
- *       the complex plane, while each character printed corresponds to a column.
+ * Preview completions are ignored — the meter tracks the exact pass. On pan frames
+ * only the exposed border tiles render, so the meter honestly stops short of 100%:
+ * it shows the fraction of the frame that was recomputed.
  */
-void print_chart(int* array) {
-    for (int i = 0; i < ROWS; i++) {
-        for (int j = 0; j < COLS; j++) {
-            int value = array[i * COLS + j];
-            if (value) {
-                printf(".");
-            } else {
-                printf(" ");
-            }
-        }
-        printf("\n");
+static void progress_tick(unsigned tile_row, unsigned tile_col, int preview, void *arg) {
+    (void)tile_row;
+    (void)tile_col;
+    (void)arg;
+    if (preview) {
+        return;
+    }
+    unsigned done = __atomic_add_fetch(&progress_count, 1, __ATOMIC_RELAXED);
+    unsigned pct = 100u * done / progress_total;
+    if (pct != 100u * (done - 1) / progress_total) {
+        fprintf(stderr, "\r%3u%%", pct);
     }
 }
 
 /**
- * @brief StarPU CPU kernel function for computing Mandelbrot set stability for a specific point.
+ * @brief Prints the command-line usage of the program on stderr.
  *
- * This function is designed to be executed as a StarPU task on the CPU. It computes whether
- * a given complex number `c` is stable based on the Mandelbrot iteration and stores the result
- * in a provided array. The complex number `c` is unpacked from the task's arguments, and the
- * result is stored at the appropriate index `i` in the provided result vector.
+ * @param name The program name, as found in `argv[0]`.
+ */
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [-a] [-s] [-S] [-p] [-w cols] [-h rows] [-i iterations] [-x center_real] [-y center_imag] [-z zoom] [-o output.{pgm,raw}] [-n frames] [-Z zoom_step] [-P dx,dy] [-H histogram.csv]\n",
+            name);
+}
+
+/**
+ * @brief Parses the command-line options into an `options` structure.
  *
- * The stability of the complex number is determined using the `is_stable` function, which
- * checks if the number remains bounded under Mandelbrot iterations (with a predefined maximum
- * iteration count, `ITER`). If the point is stable (i.e., part of the Mandelbrot set), the
- * result will be `1`; otherwise, it will be `0`.
+ * Every parameter has a default reproducing the historical compile-time behavior
+ * (a 100x63 grid of the -2.0..0.5 x -1.5..1.5 viewport at 2000 iterations), so all
+ * options are optional. Invalid values (non-positive sizes, iteration counts or zoom)
+ * are rejected.
  *
- * @param buffers[] A StarPU buffer containing the result vector in which the stability
- *                  result will be stored. `buffers[0]` should point to a `starpu_vector_interface`
- *                  structure, and the result is stored in its internal array at index `i`.
- * @param cl_arg A pointer to the arguments passed to the task, which includes the complex
- *               number `c` to evaluate and the index `i` where the result will be stored.
- *               These arguments are unpacked using `starpu_codelet_unpack_args`.
+ * @param argc The argument count from `main`.
+ * @param argv The argument vector from `main`.
+ * @param opt Receives the parsed parameters.
+ * @return int Returns 0 on success, or -1 if an option is unknown or out of range.
  */
-void cpu_func(void *buffers[], void *cl_arg) {
-    double complex c;
-    int i;
-    starpu_codelet_unpack_args(cl_arg, &c);
-    starpu_codelet_unpack_args(cl_arg, &i);
-
-    struct starpu_vector_interface *vector = buffers[0];
-    int *val = (int *)STARPU_VECTOR_GET_PTR(vector);
-    int r = is_stable(c, ITER);
-    val[i] = is_stable(c, ITER);
-}
+int parse_options(int argc, char *argv[], struct options *opt) {
+    opt->rows = DEFAULT_ROWS;
+    opt->cols = DEFAULT_COLS;
+    opt->iter = DEFAULT_ITER;
+    opt->center_real = DEFAULT_CENTER_REAL;
+    opt->center_imag = DEFAULT_CENTER_IMAG;
+    opt->zoom = 1.0;
+    opt->output = NULL;
+    opt->frames = 1;
+    opt->zoom_step = 1.1;
+    opt->adaptive = 0;
+    opt->ssaa = 0;
+    opt->smooth = 0;
+    opt->progressive = 0;
+    opt->histogram = NULL;
+    opt->pan_x = 0;
+    opt->pan_y = 0;
 
-static struct starpu_codelet cl = {
-  .cpu_funcs = {cpu_func},
-  .nbuffers = 1,
-  .modes = {STARPU_R},
-};
+    int c;
+    while ((c = getopt(argc, argv, "aspSw:h:i:x:y:z:o:n:Z:P:H:")) != -1) {
+        switch (c) {
+        case 'a':
+            opt->adaptive = 1;
+            break;
+        case 's':
+            opt->ssaa = 1;
+            break;
+        case 'p':
+            opt->progressive = 1;
+            break;
+        case 'S':
+            opt->smooth = 1;
+            break;
+        case 'w':
+            opt->cols = atoi(optarg);
+            break;
+        case 'h':
+            opt->rows = atoi(optarg);
+            break;
+        case 'i':
+            opt->iter = atoi(optarg);
+            break;
+        case 'x':
+            opt->center_real = atof(optarg);
+            break;
+        case 'y':
+            opt->center_imag = atof(optarg);
+            break;
+        case 'z':
+            opt->zoom = atof(optarg);
+            break;
+        case 'o':
+            opt->output = optarg;
+            break;
+        case 'n':
+            opt->frames = atoi(optarg);
+            break;
+        case 'Z':
+            opt->zoom_step = atof(optarg);
+            break;
+        case 'P':
+            if (sscanf(optarg, "%ld,%ld", &opt->pan_x, &opt->pan_y) != 2) {
+                usage(argv[0]);
+                return -1;
+            }
+            break;
+        case 'H':
+            opt->histogram = optarg;
+            break;
+        default:
+            usage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (opt->rows < 2 || opt->cols < 2 || opt->iter <= 0 || opt->zoom <= 0.0 ||
+        opt->frames < 1 || opt->zoom_step <= 0.0) {
+        usage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
 
 /**
  * @brief Main function for computing and visualizing the Mandelbrot set using parallel tasks with StarPU.
@@ -142,62 +296,163 @@ static struct starpu_codelet cl = {
  * This function initializes the necessary data structures for computing the Mandelbrot set, registers
  * the data with StarPU, and submits tasks for parallel computation of the set's stability across a grid
  * of complex numbers. After the computations are completed, it prints a simple ASCII representation of
- * the Mandelbrot set.
- *
- * The function allocates memory for a matrix of complex numbers (`matrix`) representing points in the
- * complex plane, and for a mask (`mask`) to store the stability results (1 for stable points, 0 for
- * unstable). It then:
- *  - Fills the `matrix` with complex numbers using `fill_array`.
- *  - Registers the `mask` array with StarPU to hold task results.
- *  - Iterates over all points in the complex plane grid, submitting StarPU tasks to compute the Mandelbrot
- *    set stability for each complex number. Each task uses `cpu_func` to compute stability and store
- *    the result in the `mask`.
- *  - Waits for all tasks to complete, then unregisters the StarPU data handle and shuts down StarPU.
- *  - Prints the Mandelbrot set using `print_chart` to display an ASCII visualization.
+ * the Mandelbrot set or writes the escape-time surface to the requested output files.
  *
- * Memory for both the complex number matrix and the result mask is freed at the end of the function.
+ * The function allocates two escape-time surfaces used as a double buffer. The
+ * complex coordinates themselves are never materialized: a single `struct viewport` describes
+ * each frame and the tile kernels compute the coordinates of their points on the fly. It then:
+ *  - Initializes StarPU once and registers both surfaces with StarPU as matrices.
+ *  - Renders the requested number of frames into alternating buffers, multiplying the zoom
+ *    by `zoom_step` between frames; StarPU, its workers and the handles stay alive for the
+ *    whole animation so only the per-tile tasks are paid per frame.
+ *  - Hands every completed frame to a dedicated writer thread, which emits it with
+ *    `write_output` (or `print_chart` when no output file was given) while the next frame's
+ *    tasks execute, then unregisters the handles and shuts down StarPU.
  *
- * @note We are using a 1D array (`matrix`) to represent the complex number grid instead of a 2D array.
- *       The matrix is accessed using row-major order, where the element at position `(i, j)` in a
- *       2D array is accessed as `i * COLS + j` in the 1D array.
+ * @note We are using a 1D array (`mask`) to represent the grid instead of a 2D array.
+ *       The mask is accessed using row-major order, where the element at position `(i, j)` in a
+ *       2D array is accessed as `i * cols + j` in the 1D array.
  *
- * @return int Returns 0 on successful execution, or 1 if a memory allocation fails.
+ * @param argc The argument count.
+ * @param argv The argument vector; see `usage` for the accepted options.
+ * @return int Returns 0 on successful execution, 1 if a memory allocation or an output
+ *         write fails, or 2 if the command line is invalid.
  */
-int main(void) {
-    double complex *matrix = malloc(ROWS * COLS * sizeof(double complex));
-    if (matrix == NULL) {
-        perror("malloc");
-        return 1;
+int main(int argc, char *argv[]) {
+    struct options opt;
+    if (parse_options(argc, argv, &opt) < 0) {
+        return 2;
     }
+    unsigned rows = opt.rows;
+    unsigned cols = opt.cols;
 
-    int *mask = malloc(ROWS * COLS * sizeof(int));
-    if (mask == NULL) {
-        perror("malloc");
+    starpu_init(NULL);
+    select_cpu_kernel();
+    set_adaptive_mode(opt.adaptive);
+    set_supersample_mode(opt.ssaa);
+    set_smooth_mode(opt.smooth);
+    set_progressive_mode(opt.progressive);
+    set_stats_mode(opt.histogram != NULL);
+
+    /*
+     * Out-of-core mode: a `.mbt` output renders each frame straight into a
+     * memory-mapped tiled file, so no full-frame buffer (16 GiB at poster sizes)
+     * is ever allocated and the double-buffer/writer machinery is bypassed.
+     */
+    const char *out_ext = opt.output != NULL ? strrchr(opt.output, '.') : NULL;
+    if (out_ext != NULL && strcmp(out_ext, ".mbt") == 0) {
+        int ret = 0;
+        double zoom = opt.zoom;
+        double center_real = opt.center_real;
+        double center_imag = opt.center_imag;
+        for (unsigned frame = 0; frame < opt.frames; frame++) {
+            struct viewport view = viewport_centered(center_real, center_imag,
+                                                     zoom, rows, cols);
+            char path[4096];
+            frame_path(path, sizeof(path), opt.output, opt.frames, frame);
+            if (render_frame_mbt(path, rows, cols, &view, opt.iter) < 0) {
+                ret = 1;
+                break;
+            }
+            zoom *= opt.zoom_step;
+            center_real += opt.pan_x * view.real_step;
+            center_imag += opt.pan_y * view.imag_step;
+        }
+        deep_cache_drop();
+        starpu_shutdown();
+        return ret;
+    }
+
+    /*
+     * Double-buffered surfaces: frame N renders into buffer N % 2 while the writer
+     * thread is still emitting frame N - 1 from the other buffer. The writer's
+     * one-slot mailbox guarantees frame N - 2 has left a buffer before frame N
+     * renders into it. Pinned allocation so tile results can come back from
+     * devices as async DMAs.
+     */
+    size_t mask_size = (size_t)rows * cols * sizeof(uint32_t);
+    uint32_t *masks[2];
+    starpu_data_handle_t mask_handles[2];
+    for (int b = 0; b < 2; b++) {
+        masks[b] = mb_alloc(mask_size);
+        if (masks[b] == NULL) {
+            perror("starpu_malloc");
+            starpu_shutdown();
+            return 1;
+        }
+        starpu_matrix_data_register(&mask_handles[b], STARPU_MAIN_RAM, (uintptr_t)masks[b],
+                                    cols, cols, rows, sizeof(uint32_t));
+    }
+
+    pthread_t writer_thread;
+    if (pthread_create(&writer_thread, NULL, writer_main, NULL) != 0) {
+        perror("pthread_create");
+        starpu_shutdown();
         return 1;
     }
 
-    fill_array(matrix);
+    if (opt.progressive) {
+        progress_total = ((rows + TILE_ROWS - 1) / TILE_ROWS) *
+                         ((cols + TILE_COLS - 1) / TILE_COLS);
+        set_progress_callback(progress_tick, NULL);
+    }
 
-    starpu_init(NULL);
-    starpu_data_handle_t matrix_handle;
-    starpu_vector_data_register(&matrix_handle, 0, (uintptr_t)mask, ROWS * COLS, sizeof(int));
-
-    for (int i = 0; i < ROWS * COLS; i++) {
-        double complex c = matrix[i];
-        starpu_task_insert(
-            &cl, STARPU_R, matrix_handle,
-            STARPU_VALUE, &c, sizeof(double complex),
-            STARPU_VALUE, &i, sizeof(int),
-            0);
+    int ret = 0;
+    double zoom = opt.zoom;
+    double center_real = opt.center_real;
+    double center_imag = opt.center_imag;
+    for (unsigned frame = 0; frame < opt.frames; frame++) {
+        int b = frame % 2;
+        struct viewport view = viewport_centered(center_real, center_imag,
+                                                 zoom, rows, cols);
+        __atomic_store_n(&progress_count, 0, __ATOMIC_RELAXED);
+        // Pan frames (constant zoom, whole-pixel shifts) reuse the surviving
+        // pixels of the previous frame and only render the exposed border tiles.
+        render_frame_pan(mask_handles[b], masks[b], rows, cols, &view, opt.iter);
+        if (opt.progressive) {
+            fputc('\n', stderr);
+        }
+
+        // The reduction made the histogram available with the frame itself.
+        if (opt.histogram != NULL) {
+            char hist_path[4096];
+            frame_path(hist_path, sizeof(hist_path), opt.histogram, opt.frames, frame);
+            if (write_histogram(hist_path) < 0) {
+                ret = 1;
+            }
+        }
+
+        // Hand the frame to the writer thread; it writes while the next renders.
+        // Smooth-mode values carry SMOOTH_BITS fractional bits, so the scale the
+        // output stages normalize against grows by the same factor.
+        struct writer_job job = {
+            .mask = masks[b],
+            .rows = rows,
+            .cols = cols,
+            .iter = opt.smooth ? opt.iter << SMOOTH_BITS : opt.iter,
+            .print = opt.output == NULL,
+        };
+        if (opt.output != NULL) {
+            frame_path(job.path, sizeof(job.path), opt.output, opt.frames, frame);
+        }
+        writer_submit(&job);
+
+        zoom *= opt.zoom_step;
+        center_real += opt.pan_x * view.real_step;
+        center_imag += opt.pan_y * view.imag_step;
     }
 
-    starpu_task_wait_for_all();
-    starpu_data_unregister(matrix_handle);
+    if (writer_finish(writer_thread) < 0) {
+        ret = 1;
+    }
+    pan_cache_drop();
+    deep_cache_drop();
+    stats_drop();
+    for (int b = 0; b < 2; b++) {
+        starpu_data_unregister(mask_handles[b]);
+        mb_free(masks[b], mask_size);
+    }
     starpu_shutdown();
 
-    print_chart(mask);
-
-    free(matrix);
-    free(mask);
-    return 0;
+    return ret;
 }
@@ -0,0 +1,233 @@
+#ifndef MANDELBROT_H
+#define MANDELBROT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <starpu.h>
+
+/*
+ * Extent of the viewport along the real and imaginary axes at zoom 1. Together
+ * with a center point and a zoom factor this fully determines a frame.
+ */
+#define BASE_REAL_SPAN 2.5
+#define BASE_IMAG_SPAN 3.0
+
+/*
+ * Tile dimensions for task granularity. Each StarPU task processes one
+ * TILE_ROWS x TILE_COLS block of the grid instead of a single point, so
+ * the per-task scheduling overhead is amortized over thousands of pixels.
+ * Both can be overridden at compile time (e.g. -DTILE_ROWS=32).
+ */
+#ifndef TILE_ROWS
+#define TILE_ROWS 64
+#endif
+#ifndef TILE_COLS
+#define TILE_COLS 64
+#endif
+
+/**
+ * @brief Describes the mapping from grid coordinates to the complex plane.
+ *
+ * The point at grid position `(row, col)` corresponds to the complex number
+ * `(real_start + col * real_step) + (imag_start + row * imag_step) * I`. One viewport
+ * describes the whole frame; the tile kernels combine it with the tile position carried
+ * in their argument descriptor and compute the coordinates of each point on the fly, so
+ * no matrix of complex numbers ever needs to be materialized in memory.
+ */
+struct viewport {
+    double real_start;
+    double imag_start;
+    double real_step;
+    double imag_step;
+};
+
+/*
+ * Fractional bits of the smooth-coloring escape values. In smooth mode the surface
+ * holds 24.8 fixed-point smooth iteration values (`n + 1 - log2(log2(|z|))`) instead
+ * of integer escape counts; 8 fractional bits resolve 1/256th of an iteration band,
+ * far below what any color ramp can show.
+ */
+#define SMOOTH_BITS 8
+
+/*
+ * Scratch bit of the supersampling passes (CPU `refine_tile`, CUDA `refine_kernel`):
+ * boundary pixels are decided on the unmodified single-sample surface first and tagged
+ * in place, then refined in a second pass, so no pixel's boundary test ever sees an
+ * already-averaged neighbor. The bit is free because escape counts are bounded by the
+ * iteration budget, a positive `int`; it never survives into the finished tile.
+ */
+#define REFINE_TAG 0x80000000u
+
+/**
+ * @brief Codelet argument descriptor of one tile task.
+ *
+ * Passed to every tile task by pointer (`STARPU_CL_ARGS_NFREE`) instead of being packed
+ * per task with `STARPU_VALUE`: the descriptors of a frame live in a preallocated arena
+ * reused from frame to frame, so the submission path performs no per-task allocation or
+ * copy at all. The descriptors must stay alive until the frame's tasks complete
+ * (`finish_frame`).
+ *
+ * The tile's position in the frame is carried here rather than derived from the
+ * sub-matrix offset inside the kernel: interface offsets describe the home-node
+ * replicate only (a replicate allocated on another memory node or a device starts at
+ * offset 0), so offset-derived positions break the moment a tile executes away from
+ * the registration node.
+ */
+struct tile_args {
+    struct viewport view;
+    unsigned row0; /* global row of the tile's first point */
+    unsigned col0; /* global column of the tile's first point */
+    int iter;
+    int ssaa;   /* refine boundary pixels with extra sub-pixel samples */
+    int smooth; /* surface holds 24.8 fixed-point smooth escape values */
+
+    /*
+     * Perturbation engine fields (deep zoom only): the global pixel position the
+     * reference orbit was iterated at, its exact coordinate, and the number of
+     * valid orbit entries.
+     */
+    long ref_row;
+    long ref_col;
+    int ref_len;
+    long double ref_cr;
+    long double ref_ci;
+};
+
+/*
+ * On-disk layout of the tiled `.mbt` output format used for out-of-core renders:
+ * a `struct mbt_header` at offset 0, immediately followed by the tile-completion
+ * bitmap (one bit per tile in tile-major order, set once the tile's results are
+ * on their way to the file — the checkpoint journal an interrupted render resumes
+ * from), padded together to a multiple of `MBT_HEADER_SIZE` so the tile data at
+ * `data_off` starts page-aligned. The tiles follow in tile-major (row of tiles,
+ * then column) order; every tile occupies a fixed slot of `tile_rows * tile_cols`
+ * little-endian 32-bit escape counts, edge tiles use the top-left part of their
+ * slot and leave the rest zeroed.
+ */
+#define MBT_MAGIC "MBT1"
+#define MBT_HEADER_SIZE 4096
+
+/*
+ * Rendering-mode bits of `mbt_header.flags`. The modes change what a tile's payload
+ * means (fixed-point smooth values vs. integer counts, supersampled vs. single-sample,
+ * iso-band approximated vs. exhaustive), so a resumed render must have been started
+ * with the same flags — a header carrying different ones restarts the file.
+ */
+#define MBT_FLAG_SMOOTH (1u << 0)   /* tiles hold 24.8 fixed-point smooth values */
+#define MBT_FLAG_SSAA (1u << 1)     /* boundary pixels were supersampled */
+#define MBT_FLAG_ADAPTIVE (1u << 2) /* rendered with the Mariani-Silver kernel */
+
+struct mbt_header {
+    char magic[4];      /* MBT_MAGIC */
+    uint32_t rows;      /* frame height in pixels */
+    uint32_t cols;      /* frame width in pixels */
+    uint32_t tile_rows; /* tile slot height in pixels */
+    uint32_t tile_cols; /* tile slot width in pixels */
+    uint32_t iter;      /* iteration budget the counts were computed with */
+    uint32_t data_off;  /* file offset of the first tile slot */
+    uint32_t flags;     /* rendering mode, MBT_FLAG_* bits */
+
+    /* Viewport of the render, so a resumed render can verify it matches. */
+    double real_start;
+    double imag_start;
+    double real_step;
+    double imag_step;
+};
+
+#ifdef __CUDACC__
+#define MB_INLINE static __host__ __device__ inline
+#else
+#define MB_INLINE static inline
+#endif
+
+/**
+ * @brief Tests whether a point lies inside the main cardioid or the period-2 bulb.
+ *
+ * Both regions have closed-form boundaries: the main cardioid satisfies
+ * `q * (q + x - 1/4) <= y^2 / 4` with `q = (x - 1/4)^2 + y^2`, and the period-2 bulb
+ * `(x + 1)^2 + y^2 <= 1/16`. Points inside either region never escape, so the iteration
+ * loop can be skipped entirely for them — a dozen FLOPs instead of the full budget for
+ * what would otherwise be the most expensive pixels of the frame.
+ *
+ * @param x The real part of the point.
+ * @param y The imaginary part of the point.
+ * @return int Returns 1 if the point is provably interior, 0 otherwise.
+ */
+MB_INLINE int in_main_bulbs(double x, double y) {
+    double q = (x - 0.25) * (x - 0.25) + y * y;
+    if (q * (q + x - 0.25) <= 0.25 * y * y) {
+        return 1;
+    }
+    return (x + 1.0) * (x + 1.0) + y * y <= 0.0625;
+}
+
+#ifndef __cplusplus
+
+#include <complex.h>
+
+/* Reference scalar kernel (render.c). */
+int escape_time(double complex c, int iter);
+
+/* Pinned, DMA-capable allocation for registered buffers (render.c). */
+void *mb_alloc(size_t size);
+void mb_free(void *ptr, size_t size);
+
+/* Viewport construction (render.c). */
+struct viewport viewport_centered(double center_real, double center_imag, double zoom,
+                                  unsigned rows, unsigned cols);
+
+/* Kernel selection and frame rendering (render.c). */
+void select_cpu_kernel(void);
+
+/* CPU tile kernel inventory for the microbenchmark harness (render.c). */
+struct cpu_kernel {
+    const char *name;
+    void (*func)(void *buffers[], void *cl_arg);
+};
+const struct cpu_kernel *cpu_kernels(unsigned *count);
+void set_adaptive_mode(int enable);
+void set_supersample_mode(int enable);
+void set_smooth_mode(int enable);
+void set_progressive_mode(int enable);
+void set_progress_callback(void (*cb)(unsigned tile_row, unsigned tile_col, int preview,
+                                      void *arg),
+                           void *arg);
+struct starpu_codelet *frame_codelet(const struct viewport *view);
+unsigned submit_frame(starpu_data_handle_t mask_handle, unsigned rows, unsigned cols,
+                      const struct viewport *view, int iter);
+void finish_frame(starpu_data_handle_t mask_handle);
+void render_frame(starpu_data_handle_t mask_handle, unsigned rows, unsigned cols,
+                  const struct viewport *view, int iter);
+void render_frame_pan(starpu_data_handle_t mask_handle, uint32_t *mask,
+                      unsigned rows, unsigned cols, const struct viewport *view, int iter);
+void pan_cache_drop(void);
+void deep_cache_drop(void);
+
+/* Per-frame escape-count statistics (render.c). */
+void set_stats_mode(int enable);
+int write_histogram(const char *path);
+void stats_drop(void);
+
+/* Output (render.c). */
+void print_chart(uint32_t *array, unsigned rows, unsigned cols, int iter);
+int write_raw(const char *path, const uint32_t *array, unsigned rows, unsigned cols);
+int write_pgm(const char *path, const uint32_t *array, unsigned rows, unsigned cols, int iter);
+int write_output(const char *path, const uint32_t *array, unsigned rows, unsigned cols, int iter);
+int render_frame_mbt(const char *path, unsigned rows, unsigned cols,
+                     const struct viewport *view, int iter);
+void frame_path(char *buf, size_t len, const char *output, unsigned frames, unsigned frame);
+
+#endif /* !__cplusplus */
+
+#ifdef STARPU_USE_CUDA
+#ifdef __cplusplus
+extern "C" {
+#endif
+void cuda_func(void *buffers[], void *cl_arg);
+void cuda_func_smooth(void *buffers[], void *cl_arg);
+#ifdef __cplusplus
+}
+#endif
+#endif
+
+#endif /* MANDELBROT_H */
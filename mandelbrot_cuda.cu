@@ -0,0 +1,261 @@
+#include <starpu.h>
+#include "mandelbrot.h"
+
+/**
+ * @brief CUDA kernel computing the Mandelbrot escape time for one tile of the mask.
+ *
+ * One thread handles one point of the tile: it computes the complex coordinate of the
+ * point from the viewport and the tile's position in the frame, iterates `z = z^2 + c`
+ * until the squared magnitude exceeds 4 or `iter` iterations are reached, and stores the
+ * resulting iteration count in the mask tile. The semantics match the CPU `escape_time`
+ * exactly, so the scheduler is free to mix CPU and CUDA tiles within one frame.
+ *
+ * @param val Device pointer to the tile of the result mask.
+ * @param nx Number of columns of the tile.
+ * @param ny Number of rows of the tile.
+ * @param ld Leading dimension used to address rows inside the parent matrix.
+ * @param row0 Global row of the tile's first point.
+ * @param col0 Global column of the tile's first point.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ */
+/**
+ * @brief Device-side escape-time computation for one point, mirroring the CPU `escape_time`.
+ *
+ * @param cr The real part of the point.
+ * @param ci The imaginary part of the point.
+ * @param iter The maximum number of iterations per point.
+ * @return uint32_t The escape time of the point.
+ */
+static __device__ uint32_t device_escape_time(double cr, double ci, int iter) {
+    if (in_main_bulbs(cr, ci)) {
+        return (uint32_t)iter;
+    }
+    double zr = 0.0, zi = 0.0, zr2 = 0.0, zi2 = 0.0;
+    double sr = 0.0, si = 0.0;
+    int next_save = 8;
+    for (int n = 0; n < iter; n++) {
+        zi = (zr + zr) * zi + ci;
+        zr = zr2 - zi2 + cr;
+        zr2 = zr * zr;
+        zi2 = zi * zi;
+        if (zr2 + zi2 > 4.0) {
+            return (uint32_t)n;
+        }
+        // Brent-style periodicity detection, mirroring the CPU escape_time.
+        if (zr == sr && zi == si) {
+            break;
+        }
+        if (n == next_save) {
+            sr = zr;
+            si = zi;
+            next_save *= 2;
+        }
+    }
+    return (uint32_t)iter;
+}
+
+static __global__ void mandelbrot_kernel(uint32_t *val, unsigned nx, unsigned ny, unsigned ld,
+                                         unsigned row0, unsigned col0, struct viewport view,
+                                         int iter) {
+    unsigned j = blockIdx.x * blockDim.x + threadIdx.x;
+    unsigned i = blockIdx.y * blockDim.y + threadIdx.y;
+    if (i >= ny || j >= nx) {
+        return;
+    }
+
+    double cr = view.real_start + (col0 + j) * view.real_step;
+    double ci = view.imag_start + (row0 + i) * view.imag_step;
+    val[i * ld + j] = device_escape_time(cr, ci, iter);
+}
+
+/**
+ * @brief Device-side smooth escape value in 24.8 fixed point, mirroring `escape_time_smooth`.
+ *
+ * On escape the integer count is refined with `n + 1 - log2(log2(|z|))`, computed from
+ * the squared magnitude the escape test already holds; see `SMOOTH_BITS`.
+ *
+ * @param cr The real part of the point.
+ * @param ci The imaginary part of the point.
+ * @param iter The maximum number of iterations per point.
+ * @return uint32_t The smooth escape value in 24.8 fixed point.
+ */
+static __device__ uint32_t device_escape_time_smooth(double cr, double ci, int iter) {
+    if (in_main_bulbs(cr, ci)) {
+        return (uint32_t)iter << SMOOTH_BITS;
+    }
+    double zr = 0.0, zi = 0.0, zr2 = 0.0, zi2 = 0.0;
+    double sr = 0.0, si = 0.0;
+    int next_save = 8;
+    for (int n = 0; n < iter; n++) {
+        zi = (zr + zr) * zi + ci;
+        zr = zr2 - zi2 + cr;
+        zr2 = zr * zr;
+        zi2 = zi * zi;
+        if (zr2 + zi2 > 4.0) {
+            double nu = (double)n + 1.0 - log2(0.5 * log2(zr2 + zi2));
+            long v = lround(nu * (double)(1 << SMOOTH_BITS));
+            return v < 0 ? 0u : (uint32_t)v;
+        }
+        if (zr == sr && zi == si) {
+            break;
+        }
+        if (n == next_save) {
+            sr = zr;
+            si = zi;
+            next_save *= 2;
+        }
+    }
+    return (uint32_t)iter << SMOOTH_BITS;
+}
+
+static __global__ void mandelbrot_kernel_smooth(uint32_t *val, unsigned nx, unsigned ny,
+                                                unsigned ld, unsigned row0, unsigned col0,
+                                                struct viewport view, int iter) {
+    unsigned j = blockIdx.x * blockDim.x + threadIdx.x;
+    unsigned i = blockIdx.y * blockDim.y + threadIdx.y;
+    if (i >= ny || j >= nx) {
+        return;
+    }
+
+    double cr = view.real_start + (col0 + j) * view.real_step;
+    double ci = view.imag_start + (row0 + i) * view.imag_step;
+    val[i * ld + j] = device_escape_time_smooth(cr, ci, iter);
+}
+
+/**
+ * @brief Anti-aliasing mark pass: tags the boundary pixels of a computed tile.
+ *
+ * CUDA counterpart of the first `refine_tile` sweep: one thread per pixel compares its
+ * single-sample escape count against the in-tile neighbors and sets `REFINE_TAG` on
+ * its own value where they differ. Threads of the same launch read pixels that sibling
+ * threads concurrently tag, but a tag is the only in-flight modification and the
+ * comparisons mask it out (32-bit aligned accesses do not tear), so every decision is
+ * made on the original single-sample counts regardless of thread order. The averaged
+ * values are only written by `refine_apply_kernel` in a separate launch, after every
+ * decision of this one is final.
+ */
+static __global__ void refine_mark_kernel(uint32_t *val, unsigned nx, unsigned ny,
+                                          unsigned ld) {
+    unsigned j = blockIdx.x * blockDim.x + threadIdx.x;
+    unsigned i = blockIdx.y * blockDim.y + threadIdx.y;
+    if (i >= ny || j >= nx) {
+        return;
+    }
+
+    unsigned up = i > 0 ? i - 1 : i;
+    unsigned down = i + 1 < ny ? i + 1 : i;
+    unsigned left = j > 0 ? j - 1 : j;
+    unsigned right = j + 1 < nx ? j + 1 : j;
+    uint32_t center = val[i * ld + j] & ~REFINE_TAG;
+    if (center == (val[up * ld + j] & ~REFINE_TAG) &&
+        center == (val[down * ld + j] & ~REFINE_TAG) &&
+        center == (val[i * ld + left] & ~REFINE_TAG) &&
+        center == (val[i * ld + right] & ~REFINE_TAG)) {
+        return;
+    }
+    val[i * ld + j] = center | REFINE_TAG;
+}
+
+/**
+ * @brief Anti-aliasing apply pass: supersamples the pixels tagged by the mark pass.
+ *
+ * Second sweep of the CUDA refine: every tagged pixel averages four extra samples at
+ * quarter-step offsets into its stored value. Each thread touches only its own pixel,
+ * so the launch is race-free; stream ordering makes the mark pass's tags visible.
+ */
+static __global__ void refine_apply_kernel(uint32_t *val, unsigned nx, unsigned ny,
+                                           unsigned ld, unsigned row0, unsigned col0,
+                                           struct viewport view, int iter) {
+    unsigned j = blockIdx.x * blockDim.x + threadIdx.x;
+    unsigned i = blockIdx.y * blockDim.y + threadIdx.y;
+    if (i >= ny || j >= nx) {
+        return;
+    }
+    if (!(val[i * ld + j] & REFINE_TAG)) {
+        return;
+    }
+
+    double cr = view.real_start + (col0 + j) * view.real_step;
+    double ci = view.imag_start + (row0 + i) * view.imag_step;
+    unsigned long long sum = val[i * ld + j] & ~REFINE_TAG;
+    for (int sy = -1; sy <= 1; sy += 2) {
+        for (int sx = -1; sx <= 1; sx += 2) {
+            sum += device_escape_time(cr + sx * 0.25 * view.real_step,
+                                      ci + sy * 0.25 * view.imag_step, iter);
+        }
+    }
+    val[i * ld + j] = (uint32_t)((sum + 2) / 5);
+}
+
+/**
+ * @brief StarPU CUDA kernel function for computing Mandelbrot set stability over one tile.
+ *
+ * CUDA counterpart of `cpu_func`: it receives the same tile of the result mask and the
+ * same argument descriptor carrying the viewport and the tile's position in the frame
+ * (the device replicate starts at offset 0, so the interface offset says nothing about
+ * the position), and launches `mandelbrot_kernel` with one thread per point on the
+ * worker's local stream. The codelet is flagged `STARPU_CUDA_ASYNC`, so the launch
+ * returns immediately and StarPU synchronizes the stream when the tile's results are
+ * needed.
+ *
+ * @param buffers[] StarPU buffers for this tile. `buffers[0]` is the tile of the result
+ *                  mask as a `starpu_matrix_interface` in device memory.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+extern "C" void cuda_func(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = (const struct tile_args *)cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = (struct starpu_matrix_interface *)buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    dim3 threads(16, 16);
+    dim3 blocks((nx + threads.x - 1) / threads.x, (ny + threads.y - 1) / threads.y);
+    mandelbrot_kernel<<<blocks, threads, 0, starpu_cuda_get_local_stream()>>>(
+        val, nx, ny, ld, row0, col0, view, iter);
+    if (args->ssaa) {
+        // Same stream: the mark pass observes the finished single-sample tile,
+        // the apply pass the finished tags.
+        refine_mark_kernel<<<blocks, threads, 0, starpu_cuda_get_local_stream()>>>(
+            val, nx, ny, ld);
+        refine_apply_kernel<<<blocks, threads, 0, starpu_cuda_get_local_stream()>>>(
+            val, nx, ny, ld, row0, col0, view, iter);
+    }
+}
+
+/**
+ * @brief StarPU CUDA kernel function for the smooth-coloring tile codelet.
+ *
+ * CUDA counterpart of `cpu_func_smooth`: identical to `cuda_func` but launching
+ * `mandelbrot_kernel_smooth`. No refine pass — smooth mode skips the boundary
+ * supersampling, whose equality test is meaningless on continuous values.
+ *
+ * @param buffers[] StarPU buffers for this tile. `buffers[0]` is the tile of the result
+ *                  mask as a `starpu_matrix_interface` in device memory.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+extern "C" void cuda_func_smooth(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = (const struct tile_args *)cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = (struct starpu_matrix_interface *)buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    dim3 threads(16, 16);
+    dim3 blocks((nx + threads.x - 1) / threads.x, (ny + threads.y - 1) / threads.y);
+    mandelbrot_kernel_smooth<<<blocks, threads, 0, starpu_cuda_get_local_stream()>>>(
+        val, nx, ny, ld, row0, col0, view, iter);
+}
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <starpu.h>
+#include <starpu_mpi.h>
+
+#include "mandelbrot.h"
+
+/*
+ * Height of one distributed strip. Strips are the unit of ownership between MPI
+ * ranks; the value matches the tile height of the single-node renderer so one strip
+ * task has the same cost profile as one row of tiles there.
+ */
+#define STRIP_ROWS 64
+
+/* Same defaults as the single-node renderer. */
+#define DEFAULT_ROWS 63
+#define DEFAULT_COLS 100
+#define DEFAULT_ITER 2000
+#define DEFAULT_CENTER_REAL -0.75
+#define DEFAULT_CENTER_IMAG 0.0
+
+/**
+ * @brief Prints the command-line usage of the MPI renderer on stderr.
+ *
+ * @param name The program name, as found in `argv[0]`.
+ */
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: mpirun ... %s [-w cols] [-h rows] [-i iterations] [-x center_real] [-y center_imag] [-z zoom] [-o output.{pgm,raw}] [-n frames] [-Z zoom_step]\n",
+            name);
+}
+
+/**
+ * @brief Distributed renderer: block-distributes strips of the frame across MPI ranks.
+ *
+ * The frame is cut into `STRIP_ROWS`-high strips and every rank registers all of them
+ * (aliasing into a full-size local surface, as the StarPU-MPI examples do);
+ * `starpu_mpi_data_register` then assigns each strip a contiguous block of ranks as
+ * owner. Each frame, every rank submits the same sequence of `starpu_mpi_task_insert`
+ * calls — StarPU-MPI executes each strip task on the rank owning the written strip, so
+ * the tile codelets run unchanged — followed by one detached
+ * `starpu_mpi_get_data_on_node_detached` per strip towards rank 0. The gathers are
+ * asynchronous: strips finished early travel to rank 0 while the remaining strips are
+ * still computing, overlapping communication with computation. Rank 0 acquires the
+ * strips and writes the frame; all other ranks produce no output.
+ *
+ * The strip tasks carry per-strip argument descriptors placing each strip at its first
+ * row of the frame, so the tile codelets compute the same coordinates the single-node
+ * renderer would.
+ *
+ * @param argc The argument count.
+ * @param argv The argument vector; see `usage` for the accepted options.
+ * @return int Returns 0 on success, 1 if an allocation or an output write fails, or 2
+ *         if the command line is invalid.
+ */
+int main(int argc, char *argv[]) {
+    unsigned rows = DEFAULT_ROWS;
+    unsigned cols = DEFAULT_COLS;
+    int iter = DEFAULT_ITER;
+    double center_real = DEFAULT_CENTER_REAL;
+    double center_imag = DEFAULT_CENTER_IMAG;
+    double zoom = 1.0;
+    const char *output = NULL;
+    unsigned frames = 1;
+    double zoom_step = 1.1;
+
+    int c;
+    while ((c = getopt(argc, argv, "w:h:i:x:y:z:o:n:Z:")) != -1) {
+        switch (c) {
+        case 'w':
+            cols = atoi(optarg);
+            break;
+        case 'h':
+            rows = atoi(optarg);
+            break;
+        case 'i':
+            iter = atoi(optarg);
+            break;
+        case 'x':
+            center_real = atof(optarg);
+            break;
+        case 'y':
+            center_imag = atof(optarg);
+            break;
+        case 'z':
+            zoom = atof(optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 'Z':
+            zoom_step = atof(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (rows < 2 || cols < 2 || iter <= 0 || zoom <= 0.0 || frames < 1 || zoom_step <= 0.0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    starpu_mpi_init_conf(&argc, &argv, 1, MPI_COMM_WORLD, NULL);
+    int rank, size;
+    starpu_mpi_comm_rank(MPI_COMM_WORLD, &rank);
+    starpu_mpi_comm_size(MPI_COMM_WORLD, &size);
+    select_cpu_kernel();
+
+    size_t mask_size = (size_t)rows * cols * sizeof(uint32_t);
+    uint32_t *mask = mb_alloc(mask_size);
+    unsigned nstrips = (rows + STRIP_ROWS - 1) / STRIP_ROWS;
+    starpu_data_handle_t *strips = malloc(nstrips * sizeof(*strips));
+    // Zero-allocated: the frame loop assigns only the fields the strip tasks use,
+    // and the rest of the descriptor (smooth, perturbation state) must read as off.
+    struct tile_args *args = calloc(nstrips, sizeof(*args));
+    if (mask == NULL || strips == NULL || args == NULL) {
+        perror("malloc");
+        starpu_mpi_shutdown();
+        return 1;
+    }
+
+    for (unsigned s = 0; s < nstrips; s++) {
+        unsigned row0 = s * STRIP_ROWS;
+        unsigned height = rows - row0 < STRIP_ROWS ? rows - row0 : STRIP_ROWS;
+        starpu_matrix_data_register(&strips[s], STARPU_MAIN_RAM,
+                                    (uintptr_t)(mask + (size_t)row0 * cols),
+                                    cols, cols, height, sizeof(uint32_t));
+        // Block distribution: contiguous runs of strips live on the same rank.
+        starpu_mpi_data_register(strips[s], (starpu_mpi_tag_t)s,
+                                 (int)((starpu_mpi_tag_t)s * size / nstrips));
+    }
+
+    int ret = 0;
+    for (unsigned frame = 0; frame < frames; frame++) {
+        struct viewport view = viewport_centered(center_real, center_imag, zoom, rows, cols);
+        struct starpu_codelet *codelet = frame_codelet(&view);
+
+        for (unsigned s = 0; s < nstrips; s++) {
+            args[s].view = view;
+            args[s].row0 = s * STRIP_ROWS;
+            args[s].col0 = 0;
+            args[s].iter = iter;
+            args[s].ssaa = 0;
+            starpu_mpi_task_insert(MPI_COMM_WORLD, codelet,
+                                   STARPU_W, strips[s],
+                                   STARPU_CL_ARGS_NFREE, &args[s], sizeof(args[s]),
+                                   0);
+        }
+        // Asynchronous gather: the detached transfers post immediately and each
+        // strip travels as soon as its task finishes, while the rest still compute
+        // (the blocking starpu_mpi_get_data_on_node would serialize on every strip).
+        for (unsigned s = 0; s < nstrips; s++) {
+            starpu_mpi_get_data_on_node_detached(MPI_COMM_WORLD, strips[s], 0, NULL, NULL);
+        }
+        starpu_mpi_wait_for_all(MPI_COMM_WORLD);
+
+        if (rank == 0) {
+            for (unsigned s = 0; s < nstrips; s++) {
+                starpu_data_acquire(strips[s], STARPU_R);
+            }
+            if (output != NULL) {
+                char path[4096];
+                frame_path(path, sizeof(path), output, frames, frame);
+                if (write_output(path, mask, rows, cols, iter) < 0) {
+                    ret = 1;
+                }
+            } else {
+                print_chart(mask, rows, cols, iter);
+            }
+            for (unsigned s = 0; s < nstrips; s++) {
+                starpu_data_release(strips[s]);
+            }
+        }
+        // A failed write is only known to rank 0; keep all ranks in the frame loop
+        // (the gathers are collective) and report the failure at exit instead.
+        zoom *= zoom_step;
+    }
+
+    for (unsigned s = 0; s < nstrips; s++) {
+        starpu_data_unregister(strips[s]);
+    }
+    free(strips);
+    free(args);
+    mb_free(mask, mask_size);
+    starpu_mpi_shutdown();
+    return ret;
+}
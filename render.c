@@ -0,0 +1,2254 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <complex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <starpu.h>
+
+#include "mandelbrot.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Builds the viewport of a frame centered on a point of the complex plane.
+ *
+ * The frame is centered on `(center_real, center_imag)` and covers `BASE_REAL_SPAN / zoom`
+ * along the real axis and `BASE_IMAG_SPAN / zoom` along the imaginary axis; the per-pixel
+ * steps follow from the grid resolution.
+ *
+ * @param center_real The real part of the viewport center.
+ * @param center_imag The imaginary part of the viewport center.
+ * @param zoom The zoom factor; the viewport extent shrinks proportionally.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @return struct viewport The viewport describing the frame.
+ */
+struct viewport viewport_centered(double center_real, double center_imag, double zoom,
+                                  unsigned rows, unsigned cols) {
+    double real_span = BASE_REAL_SPAN / zoom;
+    double imag_span = BASE_IMAG_SPAN / zoom;
+    struct viewport view = {
+        .real_start = center_real - real_span / 2.0,
+        .imag_start = center_imag - imag_span / 2.0,
+        .real_step = real_span / (cols - 1),
+        .imag_step = imag_span / (rows - 1),
+    };
+    return view;
+}
+
+/**
+ * @brief Computes the escape time of a complex number under iteration of the Mandelbrot function.
+ *
+ * This function iterates the Mandelbrot equation: `z = z^2 + c`, starting with `z = 0`
+ * for a given complex number `c`. The squared magnitude of `z` is checked inside the
+ * loop, and the iteration stops as soon as it exceeds 4 (i.e., |z| > 2), since from that
+ * point on the sequence is guaranteed to diverge. For exterior points this bails out
+ * after a handful of iterations instead of grinding through the full budget, and the
+ * returned iteration count carries the escape-time information that a bare 0/1 result
+ * would throw away.
+ *
+ * Before iterating at all, the point is tested against the closed-form main cardioid
+ * and period-2 bulb boundaries (`in_main_bulbs`); points inside either region are
+ * classified as interior immediately, since those are exactly the points for which the
+ * loop would run its full budget.
+ *
+ * Interior points outside those two regions are caught by periodicity detection
+ * (Brent's cycle-finding scheme): a reference value of `z` is saved at exponentially
+ * growing intervals and every new `z` is compared against it. Once the orbit has
+ * numerically settled into a cycle it revisits the reference exactly, the point is
+ * declared interior, and the loop stops after O(cycle length) iterations instead of
+ * running the full budget.
+ *
+ * @param c The complex number to test.
+ * @param iter The maximum number of iterations to apply the Mandelbrot function.
+ * @return int The number of iterations performed before the magnitude of `z` exceeded 2,
+ *         or `iter` if the sequence never escaped (i.e., the point is considered stable).
+ */
+int escape_time(double complex c, int iter) {
+	if (in_main_bulbs(creal(c), cimag(c))) {
+		return iter;
+	}
+	double complex z = 0;
+	double complex saved = 0;
+	int next_save = 8;
+	for (int i = 0; i < iter; i++) {
+		z = z * z + c;
+		if (creal(z) * creal(z) + cimag(z) * cimag(z) > 4.0) {
+			return i;
+		}
+		if (creal(z) == creal(saved) && cimag(z) == cimag(saved)) {
+			return iter;
+		}
+		if (i == next_save) {
+			saved = z;
+			next_save *= 2;
+		}
+	}
+	return iter;
+}
+
+/*
+ * Precision-specialized family of the scalar kernel. `DEFINE_ESCAPE_TIME` expands the
+ * exact algorithm of `escape_time` (bulb precheck, escape test, Brent periodicity) for
+ * an arbitrary floating-point type, working on separate real and imaginary parts since
+ * only `double complex` has first-class `complex.h` support. The `f32` instance matches
+ * the double kernel on all but the occasional boundary pixel (a near-escape orbit can
+ * round to a count one off) whenever the per-pixel step is far above the float ulp, at
+ * half the memory traffic and twice the potential SIMD width; the `f80` instance
+ * removes the double rounding from the iteration itself for deep zooms (the coordinates
+ * still derive from the double-precision viewport).
+ */
+#define DEFINE_ESCAPE_TIME(SUFFIX, FP)                                        \
+static uint32_t escape_time_##SUFFIX(FP cr, FP ci, int iter) {                \
+    if (in_main_bulbs((double)cr, (double)ci)) {                              \
+        return (uint32_t)iter;                                                \
+    }                                                                         \
+    FP zr = 0, zi = 0, zr2 = 0, zi2 = 0;                                      \
+    FP sr = 0, si = 0;                                                        \
+    int next_save = 8;                                                        \
+    for (int i = 0; i < iter; i++) {                                          \
+        zi = (zr + zr) * zi + ci;                                             \
+        zr = zr2 - zi2 + cr;                                                  \
+        zr2 = zr * zr;                                                        \
+        zi2 = zi * zi;                                                        \
+        if (zr2 + zi2 > (FP)4.0) {                                            \
+            return (uint32_t)i;                                               \
+        }                                                                     \
+        if (zr == sr && zi == si) {                                           \
+            return (uint32_t)iter;                                            \
+        }                                                                     \
+        if (i == next_save) {                                                 \
+            sr = zr;                                                          \
+            si = zi;                                                          \
+            next_save *= 2;                                                   \
+        }                                                                     \
+    }                                                                         \
+    return (uint32_t)iter;                                                    \
+}
+
+DEFINE_ESCAPE_TIME(f32, float)
+DEFINE_ESCAPE_TIME(f80, long double)
+
+/**
+ * @brief Computes the smooth (continuous) escape value of a point in 24.8 fixed point.
+ *
+ * Same algorithm as `escape_time` (bulb precheck, escape test, Brent periodicity), but
+ * on escape the integer count is refined with the standard smooth iteration formula
+ * `n + 1 - log2(log2(|z|))`, computed from the squared magnitude the escape test already
+ * has in registers — banding-free coloring at the cost of two logarithms per escaped
+ * pixel, zero extra iterations. The value is returned with `SMOOTH_BITS` fractional
+ * bits so it travels through the existing `uint32_t` surface, output formats and caches
+ * unchanged; interior points return `iter << SMOOTH_BITS`, preserving the ordering and
+ * the interior test of the integer kernel.
+ *
+ * @param cr The real part of the point.
+ * @param ci The imaginary part of the point.
+ * @param iter The maximum number of iterations to apply the Mandelbrot function.
+ * @return uint32_t The smooth escape value in 24.8 fixed point.
+ */
+static uint32_t escape_time_smooth(double cr, double ci, int iter) {
+    if (in_main_bulbs(cr, ci)) {
+        return (uint32_t)iter << SMOOTH_BITS;
+    }
+    double zr = 0, zi = 0, zr2 = 0, zi2 = 0;
+    double sr = 0, si = 0;
+    int next_save = 8;
+    for (int i = 0; i < iter; i++) {
+        zi = (zr + zr) * zi + ci;
+        zr = zr2 - zi2 + cr;
+        zr2 = zr * zr;
+        zi2 = zi * zi;
+        if (zr2 + zi2 > 4.0) {
+            // log2|z| = log2(|z|^2) / 2; the fraction can undershoot 0 on large
+            // escape jumps, so the fixed-point value is clamped at 0 below.
+            double nu = (double)i + 1.0 - log2(0.5 * log2(zr2 + zi2));
+            long v = lround(nu * (double)(1 << SMOOTH_BITS));
+            if (v < 0) {
+                v = 0;
+            }
+            return (uint32_t)v;
+        }
+        if (zr == sr && zi == si) {
+            return (uint32_t)iter << SMOOTH_BITS;
+        }
+        if (i == next_save) {
+            sr = zr;
+            si = zi;
+            next_save *= 2;
+        }
+    }
+    return (uint32_t)iter << SMOOTH_BITS;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief Computes the escape time of 4 complex numbers at once using AVX2.
+ *
+ * This is the SIMD counterpart of `escape_time`: it iterates `z = z^2 + c` for 4 points
+ * simultaneously, keeping the real and imaginary parts in separate AVX2 lanes. The escape
+ * test compares the squared magnitude of every lane against 4 with a single vector compare,
+ * and a movemask on the result detects when all 4 orbits have diverged so the loop can stop
+ * early. Lanes that already escaped keep iterating (their values overflow harmlessly to
+ * inf/NaN) but their counters stop advancing, so the results match `escape_time` exactly.
+ *
+ * @param cr The real parts of the 4 complex numbers to test.
+ * @param ci The imaginary parts of the 4 complex numbers to test.
+ * @param iter The maximum number of iterations to apply the Mandelbrot function.
+ * @param out Receives the 4 escape times, with the same semantics as `escape_time`.
+ */
+__attribute__((target("avx2")))
+static void escape_time_avx2(const double *cr, const double *ci, int iter, uint32_t *out) {
+    __m256d vcr = _mm256_loadu_pd(cr);
+    __m256d vci = _mm256_loadu_pd(ci);
+    __m256d one = _mm256_set1_pd(1.0);
+    __m256d four = _mm256_set1_pd(4.0);
+    __m256d zr = _mm256_setzero_pd();
+    __m256d zi = _mm256_setzero_pd();
+    __m256d zr2 = _mm256_setzero_pd();
+    __m256d zi2 = _mm256_setzero_pd();
+    __m256d counts = _mm256_setzero_pd();
+
+    for (int i = 0; i < iter; i++) {
+        zi = _mm256_add_pd(_mm256_mul_pd(_mm256_add_pd(zr, zr), zi), vci);
+        zr = _mm256_add_pd(_mm256_sub_pd(zr2, zi2), vcr);
+        zr2 = _mm256_mul_pd(zr, zr);
+        zi2 = _mm256_mul_pd(zi, zi);
+        __m256d alive = _mm256_cmp_pd(_mm256_add_pd(zr2, zi2), four, _CMP_LE_OQ);
+        if (_mm256_movemask_pd(alive) == 0) {
+            break;
+        }
+        counts = _mm256_add_pd(counts, _mm256_and_pd(alive, one));
+    }
+
+    double lanes[4];
+    _mm256_storeu_pd(lanes, counts);
+    for (int l = 0; l < 4; l++) {
+        out[l] = (uint32_t)lanes[l];
+    }
+}
+
+/**
+ * @brief Computes the escape time of 8 complex numbers at once using AVX-512.
+ *
+ * Same scheme as `escape_time_avx2` but with 8 lanes per vector. The escape test uses the
+ * AVX-512 mask registers directly (`_mm512_cmp_pd_mask`) instead of a movemask, and escaped
+ * lanes are excluded from the counter increment through a masked add.
+ *
+ * @param cr The real parts of the 8 complex numbers to test.
+ * @param ci The imaginary parts of the 8 complex numbers to test.
+ * @param iter The maximum number of iterations to apply the Mandelbrot function.
+ * @param out Receives the 8 escape times, with the same semantics as `escape_time`.
+ */
+__attribute__((target("avx512f")))
+static void escape_time_avx512(const double *cr, const double *ci, int iter, uint32_t *out) {
+    __m512d vcr = _mm512_loadu_pd(cr);
+    __m512d vci = _mm512_loadu_pd(ci);
+    __m512d one = _mm512_set1_pd(1.0);
+    __m512d four = _mm512_set1_pd(4.0);
+    __m512d zr = _mm512_setzero_pd();
+    __m512d zi = _mm512_setzero_pd();
+    __m512d zr2 = _mm512_setzero_pd();
+    __m512d zi2 = _mm512_setzero_pd();
+    __m512d counts = _mm512_setzero_pd();
+
+    for (int i = 0; i < iter; i++) {
+        zi = _mm512_add_pd(_mm512_mul_pd(_mm512_add_pd(zr, zr), zi), vci);
+        zr = _mm512_add_pd(_mm512_sub_pd(zr2, zi2), vcr);
+        zr2 = _mm512_mul_pd(zr, zr);
+        zi2 = _mm512_mul_pd(zi, zi);
+        __mmask8 alive = _mm512_cmp_pd_mask(_mm512_add_pd(zr2, zi2), four, _CMP_LE_OQ);
+        if (alive == 0) {
+            break;
+        }
+        counts = _mm512_mask_add_pd(counts, alive, counts, one);
+    }
+
+    double lanes[8];
+    _mm512_storeu_pd(lanes, counts);
+    for (int l = 0; l < 8; l++) {
+        out[l] = (uint32_t)lanes[l];
+    }
+}
+
+#endif /* x86 */
+
+/**
+ * @brief Allocates a pinned, DMA-capable buffer for data that will be registered with StarPU.
+ *
+ * Thin wrapper over `starpu_malloc`, which returns page-locked memory whenever a CUDA
+ * device is present. Registering a plain `malloc` buffer forces every device transfer
+ * through a staged copy via a bounce buffer; pinned memory lets the tile results come
+ * back as asynchronous DMAs instead. All surfaces that end up registered (the escape-time
+ * mask today, color planes tomorrow) should be allocated through this wrapper. Must be
+ * called after `starpu_init`.
+ *
+ * @param size The number of bytes to allocate.
+ * @return void* The allocated buffer, or NULL on failure.
+ */
+void *mb_alloc(size_t size) {
+    void *ptr = NULL;
+    if (starpu_malloc(&ptr, size) != 0) {
+        return NULL;
+    }
+    return ptr;
+}
+
+/**
+ * @brief Releases a buffer obtained from `mb_alloc`.
+ *
+ * Must be called before `starpu_shutdown`, with the size the buffer was allocated with.
+ *
+ * @param ptr The buffer to release.
+ * @param size The size passed to `mb_alloc`.
+ */
+void mb_free(void *ptr, size_t size) {
+    starpu_free_noflag(ptr, size);
+}
+
+/**
+ * @brief Prints a simple ASCII chart representing the Mandelbrot set.
+ *
+ * This function takes an array of integers that represent the results of Mandelbrot
+ * set calculations and prints a visual representation of the set using ASCII characters.
+ * Each element in the array holds the escape time of the corresponding point, where a
+ * value of `iter` indicates that the complex number never escaped and is part of the
+ * Mandelbrot set, while smaller values indicate after how many iterations it diverged.
+ *
+ * The function prints a `.` character for stable points (value `iter`), representing
+ * points that belong to the Mandelbrot set, and a space (` `) for points that escaped,
+ * representing points outside the set.
+ *
+ * @param array A pointer to an integer array that contains the escape-time results.
+ *        The array should be of size `rows * cols`, where each element corresponds to a
+ *        point on the complex plane grid.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param iter The maximum iteration count the results were computed with.
+ *
+ * @note This function provides a very basic ASCII visualization of the Mandelbrot set
+ *       in a terminal or console. Each line printed corresponds to a row of points in
+ *       the complex plane, while each character printed corresponds to a column.
+ */
+void print_chart(uint32_t* array, unsigned rows, unsigned cols, int iter) {
+    for (unsigned i = 0; i < rows; i++) {
+        for (unsigned j = 0; j < cols; j++) {
+            uint32_t value = array[i * cols + j];
+            if (value == (uint32_t)iter) {
+                printf(".");
+            } else {
+                printf(" ");
+            }
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * @brief Writes the escape-time surface to a file as raw little-endian 32-bit values.
+ *
+ * The whole surface is emitted with a single `fwrite`, in row-major order and host
+ * byte order, with no header. This is the cheapest possible output path and the
+ * format downstream coloring tools consume directly.
+ *
+ * @param path The file to create or overwrite.
+ * @param array The escape-time surface, of size `rows * cols`.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int write_raw(const char *path, const uint32_t *array, unsigned rows, unsigned cols) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    size_t count = (size_t)rows * cols;
+    if (fwrite(array, sizeof(uint32_t), count, f) != count) {
+        perror(path);
+        fclose(f);
+        return -1;
+    }
+    if (fclose(f) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes the escape-time surface as a 16-bit binary PGM (P5) image.
+ *
+ * Escape times are scaled linearly from `0..iter` to the full 16-bit range, so points
+ * of the set come out white and fast-escaping exterior points black. The pixels are
+ * converted one row at a time into a small staging buffer (PGM requires big-endian
+ * samples) and each row is emitted with one `fwrite`, so the write path stays a few
+ * large buffered calls instead of one syscall-bound `printf` per pixel.
+ *
+ * @param path The file to create or overwrite.
+ * @param array The escape-time surface, of size `rows * cols`.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param iter The maximum iteration count the results were computed with.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int write_pgm(const char *path, const uint32_t *array, unsigned rows, unsigned cols, int iter) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    unsigned char *row = malloc((size_t)cols * 2);
+    if (row == NULL) {
+        perror("malloc");
+        fclose(f);
+        return -1;
+    }
+
+    fprintf(f, "P5\n%u %u\n65535\n", cols, rows);
+    for (unsigned i = 0; i < rows; i++) {
+        for (unsigned j = 0; j < cols; j++) {
+            uint32_t sample = (uint32_t)((uint64_t)array[i * cols + j] * 65535 / iter);
+            row[j * 2] = sample >> 8;
+            row[j * 2 + 1] = sample & 0xff;
+        }
+        if (fwrite(row, 2, cols, f) != cols) {
+            perror(path);
+            free(row);
+            fclose(f);
+            return -1;
+        }
+    }
+
+    free(row);
+    if (fclose(f) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Writes the escape-time surface to `path` in the format matching its extension.
+ *
+ * Files ending in `.pgm` are written as 16-bit PGM images; anything else is written as
+ * raw little-endian 32-bit escape times.
+ *
+ * @param path The file to create or overwrite.
+ * @param array The escape-time surface, of size `rows * cols`.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param iter The maximum iteration count the results were computed with.
+ * @return int Returns 0 on success, or -1 if the file could not be written.
+ */
+int write_output(const char *path, const uint32_t *array, unsigned rows, unsigned cols, int iter) {
+    const char *ext = strrchr(path, '.');
+    if (ext != NULL && strcmp(ext, ".pgm") == 0) {
+        return write_pgm(path, array, rows, cols, iter);
+    }
+    return write_raw(path, array, rows, cols);
+}
+
+/**
+ * @brief Anti-aliasing pass: supersamples the boundary pixels of a computed tile.
+ *
+ * For every pixel whose single-sample escape count differs from one of its in-tile
+ * neighbors — exactly the pixels sitting on an escape-class boundary — takes four
+ * extra samples at quarter-step offsets and stores the rounded average of all five.
+ * Smooth regions keep their single sample untouched, so the pass adds a few percent
+ * of compute instead of the 4x a full supersampled render would cost. Neighbors are
+ * clamped at tile edges; a boundary crossing exactly between two tiles without any
+ * in-tile variation can slip through, which is invisible in practice at 64-pixel
+ * tile granularity.
+ *
+ * The pass runs in two sweeps: the first decides every pixel on the unmodified
+ * single-sample surface and tags the boundary ones in place (`REFINE_TAG`), the
+ * second refines the tagged pixels. Refining while scanning would let later
+ * boundary tests see already-averaged neighbors, changing the decisions with the
+ * scan order; the two-sweep form decides from the pristine surface, matching the
+ * CUDA refine pass exactly.
+ *
+ * @param val The tile of the result mask, already filled by the tile kernel.
+ * @param nx The number of columns of the tile.
+ * @param ny The number of rows of the tile.
+ * @param ld The leading dimension of the mask tile.
+ * @param row0 The global row of the tile's first point.
+ * @param col0 The global column of the tile's first point.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ */
+static void refine_tile(uint32_t *val, unsigned nx, unsigned ny, unsigned ld,
+                        unsigned row0, unsigned col0, const struct viewport *view, int iter) {
+    for (unsigned i = 0; i < ny; i++) {
+        unsigned up = i > 0 ? i - 1 : i;
+        unsigned down = i + 1 < ny ? i + 1 : i;
+        for (unsigned j = 0; j < nx; j++) {
+            unsigned left = j > 0 ? j - 1 : j;
+            unsigned right = j + 1 < nx ? j + 1 : j;
+            // Masking strips the tags of already-visited pixels, so every
+            // comparison is between original single-sample counts.
+            uint32_t center = val[i * ld + j] & ~REFINE_TAG;
+            if (center == (val[up * ld + j] & ~REFINE_TAG) &&
+                center == (val[down * ld + j] & ~REFINE_TAG) &&
+                center == (val[i * ld + left] & ~REFINE_TAG) &&
+                center == (val[i * ld + right] & ~REFINE_TAG)) {
+                continue;
+            }
+            val[i * ld + j] |= REFINE_TAG;
+        }
+    }
+    for (unsigned i = 0; i < ny; i++) {
+        for (unsigned j = 0; j < nx; j++) {
+            if (!(val[i * ld + j] & REFINE_TAG)) {
+                continue;
+            }
+            double cr = view->real_start + (col0 + j) * view->real_step;
+            double ci = view->imag_start + (row0 + i) * view->imag_step;
+            uint64_t sum = val[i * ld + j] & ~REFINE_TAG;
+            for (int sy = -1; sy <= 1; sy += 2) {
+                for (int sx = -1; sx <= 1; sx += 2) {
+                    sum += escape_time(cr + sx * 0.25 * view->real_step +
+                                       (ci + sy * 0.25 * view->imag_step) * I, iter);
+                }
+            }
+            val[i * ld + j] = (uint32_t)((sum + 2) / 5);
+        }
+    }
+}
+
+/**
+ * @brief StarPU CPU kernel function for computing Mandelbrot set stability over one tile.
+ *
+ * This function is designed to be executed as a StarPU task on the CPU. It receives one
+ * rectangular tile of the result mask as a StarPU matrix interface produced by partitioning
+ * the full mask with block filters, and the frame's viewport together with the tile's
+ * position in the frame as its codelet argument. The complex coordinate of each point is
+ * computed on the fly from those, so no array of complex numbers is ever read from memory.
+ * For every
+ * point of the tile it evaluates `escape_time` (with the iteration budget passed alongside
+ * the viewport) and stores the resulting iteration count in the mask; a value equal to the
+ * budget means the point never escaped and is part of the Mandelbrot set.
+ *
+ * Processing a whole tile per task instead of a single point amortizes the submission,
+ * packing and queueing cost of a StarPU task over `TILE_ROWS * TILE_COLS` points, which
+ * keeps the workers busy with actual computation at large resolutions.
+ *
+ * @param buffers[] StarPU buffers for this tile. `buffers[0]` is the tile of the result
+ *                  mask, a `starpu_matrix_interface` whose leading dimension (`ld`) is
+ *                  used to address rows inside the parent matrix.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+void cpu_func(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    for (unsigned i = 0; i < ny; i++) {
+        double imag_part = view.imag_start + (row0 + i) * view.imag_step;
+        for (unsigned j = 0; j < nx; j++) {
+            double real_part = view.real_start + (col0 + j) * view.real_step;
+            val[i * ld + j] = escape_time(real_part + imag_part * I, iter);
+        }
+    }
+    if (args->ssaa) {
+        refine_tile(val, nx, ny, ld, row0, col0, &view, iter);
+    }
+}
+
+/*
+ * Precision-specialized tile kernels mirroring `cpu_func`, expanded from the same
+ * macro family as the scalar kernels. Coordinates are accumulated in the target type
+ * so the float kernel does not pay double conversions in the inner loop.
+ */
+#define DEFINE_CPU_FUNC(SUFFIX, FP)                                           \
+void cpu_func_##SUFFIX(void *buffers[], void *cl_arg) {                       \
+    const struct tile_args *args = cl_arg;                                    \
+    struct viewport view = args->view;                                        \
+    int iter = args->iter;                                                    \
+                                                                              \
+    struct starpu_matrix_interface *mask = buffers[0];                        \
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);                  \
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);                                 \
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);                                 \
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);                                 \
+    unsigned row0 = args->row0;                                               \
+    unsigned col0 = args->col0;                                               \
+                                                                              \
+    for (unsigned i = 0; i < ny; i++) {                                       \
+        FP imag_part = (FP)view.imag_start + (FP)(row0 + i) * (FP)view.imag_step; \
+        for (unsigned j = 0; j < nx; j++) {                                   \
+            FP real_part = (FP)view.real_start + (FP)(col0 + j) * (FP)view.real_step; \
+            val[i * ld + j] = escape_time_##SUFFIX(real_part, imag_part, iter); \
+        }                                                                     \
+    }                                                                         \
+    if (args->ssaa) {                                                         \
+        refine_tile(val, nx, ny, ld, row0, col0, &view, iter);                \
+    }                                                                         \
+}
+
+DEFINE_CPU_FUNC(f32, float)
+DEFINE_CPU_FUNC(f80, long double)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * @brief Walks a tile in SIMD batches of `lanes` points per step.
+ *
+ * Shared driver for the vectorized tile kernels: for every row of the tile it computes the
+ * real parts of `lanes` consecutive points into a small array (the imaginary part is shared
+ * by the whole row) and hands them to `batch`. The coordinates come straight from the
+ * viewport, so the lanes are filled with a few additions instead of gather loads. The
+ * ragged end of each row, where fewer than `lanes` points remain, falls back to the scalar
+ * `escape_time`.
+ *
+ * @param buffers[] The same tile buffers `cpu_func` receives.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ * @param lanes The number of points the batch kernel processes per call.
+ * @param batch The SIMD batch kernel (`escape_time_avx2` or `escape_time_avx512`).
+ */
+static void cpu_func_batch(void *buffers[], void *cl_arg, int lanes,
+                           void (*batch)(const double *, const double *, int, uint32_t *)) {
+    const struct tile_args *args = cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    double cr[8], ci[8];
+    for (unsigned i = 0; i < ny; i++) {
+        double imag_part = view.imag_start + (row0 + i) * view.imag_step;
+        for (int l = 0; l < lanes; l++) {
+            ci[l] = imag_part;
+        }
+        unsigned j = 0;
+        for (; j + lanes <= nx; j += lanes) {
+            // If any lane sits in the cardioid or period-2 bulb it would drag the whole
+            // vector through the full budget; let the scalar kernel short-circuit those.
+            int interior = 0;
+            for (int l = 0; l < lanes; l++) {
+                cr[l] = view.real_start + (col0 + j + l) * view.real_step;
+                interior |= in_main_bulbs(cr[l], imag_part);
+            }
+            if (interior) {
+                for (int l = 0; l < lanes; l++) {
+                    val[i * ld + j + l] = escape_time(cr[l] + imag_part * I, iter);
+                }
+            } else {
+                batch(cr, ci, iter, &val[i * ld + j]);
+            }
+        }
+        for (; j < nx; j++) {
+            double real_part = view.real_start + (col0 + j) * view.real_step;
+            val[i * ld + j] = escape_time(real_part + imag_part * I, iter);
+        }
+    }
+    if (args->ssaa) {
+        refine_tile(val, nx, ny, ld, row0, col0, &view, iter);
+    }
+}
+
+/** @brief AVX2 variant of `cpu_func`: processes the tile 4 points at a time. */
+void cpu_func_avx2(void *buffers[], void *cl_arg) {
+    cpu_func_batch(buffers, cl_arg, 4, escape_time_avx2);
+}
+
+/** @brief AVX-512 variant of `cpu_func`: processes the tile 8 points at a time. */
+void cpu_func_avx512(void *buffers[], void *cl_arg) {
+    cpu_func_batch(buffers, cl_arg, 8, escape_time_avx512);
+}
+
+#endif /* x86 */
+
+/**
+ * @brief Performance-model footprint of a tile task.
+ *
+ * A custom footprint replaces StarPU's default buffer-dimension hash outright, so
+ * whatever it omits is treated as identical work. Tile cost varies by two orders of
+ * magnitude between interior and exterior tiles of one frame, so the tile's own
+ * identity — its position in the frame — must be part of the key, or all tiles share
+ * one history bucket and dmda sees uniform cost. The raw viewport is deliberately not
+ * hashed: it changes on every zoom-animation frame, which would turn every frame into
+ * cold, uncalibrated entries, while a tile's position is a stable proxy for its cost
+ * profile across the nearly identical consecutive frames.
+ *
+ * @param task The task being estimated.
+ * @return uint32_t The history-table key for this task.
+ */
+static uint32_t tile_footprint(struct starpu_task *task) {
+    const struct tile_args *args = task->cl_arg;
+    uint32_t hash = starpu_hash_crc32c_be_n(&args->row0, sizeof(args->row0), 0);
+    hash = starpu_hash_crc32c_be_n(&args->col0, sizeof(args->col0), hash);
+    hash = starpu_hash_crc32c_be_n(&args->iter, sizeof(args->iter), hash);
+    hash = starpu_hash_crc32c_be_n(&args->ssaa, sizeof(args->ssaa), hash);
+    return starpu_hash_crc32c_be_n(&args->smooth, sizeof(args->smooth), hash);
+}
+
+/*
+ * History-based cost model for the tile codelet. With a model attached, StarPU's
+ * cost-aware schedulers (STARPU_SCHED=dmda, dmdas) can estimate each tile's duration
+ * from previous executions instead of dispatching eagerly, which removes the
+ * end-of-frame stall where one worker grinds the expensive cardioid tiles alone.
+ */
+static struct starpu_perfmodel tile_model = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile",
+  .footprint = tile_footprint,
+};
+
+/**
+ * @brief Computes the escape time of the point at global grid position `(grow, gcol)`.
+ *
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ * @param grow The global row of the point.
+ * @param gcol The global column of the point.
+ * @return uint32_t The escape time of the point.
+ */
+static uint32_t point_at(const struct viewport *view, int iter, unsigned grow, unsigned gcol) {
+    double real_part = view->real_start + gcol * view->real_step;
+    double imag_part = view->imag_start + grow * view->imag_step;
+    return escape_time(real_part + imag_part * I, iter);
+}
+
+/**
+ * @brief Mariani–Silver rectangle subdivision over one rectangle of a tile.
+ *
+ * Exploits the connectedness of the Mandelbrot set: the escape classes form connected
+ * regions, so if every border pixel of a rectangle carries the same escape count, the
+ * interior carries it too and can be filled without iterating a single interior point.
+ * The function computes the rectangle's border, fills the interior when the border is
+ * uniform, and otherwise recursively subdivides the interior into four quadrants.
+ * Rectangles too small to have an interior worth testing are computed exhaustively.
+ *
+ * @param val The tile of the result mask.
+ * @param ld The leading dimension of the mask tile.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ * @param row0 The global row of the tile's first point.
+ * @param col0 The global column of the tile's first point.
+ * @param r0 The row of the rectangle's first point, local to the tile.
+ * @param c0 The column of the rectangle's first point, local to the tile.
+ * @param nr The number of rows of the rectangle.
+ * @param nc The number of columns of the rectangle.
+ */
+static void ms_rect(uint32_t *val, unsigned ld, const struct viewport *view, int iter,
+                    unsigned row0, unsigned col0,
+                    unsigned r0, unsigned c0, unsigned nr, unsigned nc) {
+    if (nr == 0 || nc == 0) {
+        return;
+    }
+    if (nr <= 3 || nc <= 3) {
+        for (unsigned i = r0; i < r0 + nr; i++) {
+            for (unsigned j = c0; j < c0 + nc; j++) {
+                val[i * ld + j] = point_at(view, iter, row0 + i, col0 + j);
+            }
+        }
+        return;
+    }
+
+    // Compute the border and check whether it is all one escape class.
+    uint32_t first = point_at(view, iter, row0 + r0, col0 + c0);
+    int uniform = 1;
+    for (unsigned j = c0; j < c0 + nc; j++) {
+        uint32_t top = point_at(view, iter, row0 + r0, col0 + j);
+        uint32_t bottom = point_at(view, iter, row0 + r0 + nr - 1, col0 + j);
+        val[r0 * ld + j] = top;
+        val[(r0 + nr - 1) * ld + j] = bottom;
+        uniform = uniform && top == first && bottom == first;
+    }
+    for (unsigned i = r0 + 1; i < r0 + nr - 1; i++) {
+        uint32_t left = point_at(view, iter, row0 + i, col0 + c0);
+        uint32_t right = point_at(view, iter, row0 + i, col0 + c0 + nc - 1);
+        val[i * ld + c0] = left;
+        val[i * ld + c0 + nc - 1] = right;
+        uniform = uniform && left == first && right == first;
+    }
+
+    if (uniform) {
+        for (unsigned i = r0 + 1; i < r0 + nr - 1; i++) {
+            for (unsigned j = c0 + 1; j < c0 + nc - 1; j++) {
+                val[i * ld + j] = first;
+            }
+        }
+        return;
+    }
+
+    // Mixed border: subdivide the interior (the border is already done) into quadrants.
+    unsigned ir = r0 + 1, ic = c0 + 1;
+    unsigned inr = nr - 2, inc = nc - 2;
+    unsigned hr = inr / 2, hc = inc / 2;
+    ms_rect(val, ld, view, iter, row0, col0, ir, ic, hr, hc);
+    ms_rect(val, ld, view, iter, row0, col0, ir, ic + hc, hr, inc - hc);
+    ms_rect(val, ld, view, iter, row0, col0, ir + hr, ic, inr - hr, hc);
+    ms_rect(val, ld, view, iter, row0, col0, ir + hr, ic + hc, inr - hr, inc - hc);
+}
+
+/**
+ * @brief Mariani–Silver variant of `cpu_func`: computes borders first, fills uniform areas.
+ *
+ * Runs the rectangle subdivision over the whole tile. On the default viewport this skips
+ * iterating the majority of pixels (large interior and far-exterior areas are filled from
+ * their uniform borders), at the cost of classifying iso-count exterior bands by their
+ * border only — a standard, visually indistinguishable approximation.
+ *
+ * @param buffers[] The same tile buffers `cpu_func` receives.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+void cpu_func_adaptive(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    ms_rect(val, ld, &view, iter, row0, col0, 0, 0, ny, nx);
+    if (args->ssaa) {
+        refine_tile(val, nx, ny, ld, row0, col0, &view, iter);
+    }
+}
+
+/*
+ * Every tile codelet pins its buffers to the executing worker's memory node
+ * (`STARPU_SPECIFIC_NODE_LOCAL`). On NUMA machines (StarPU treats each NUMA node
+ * as a memory node) the tile is thus allocated and written on the socket of the
+ * worker computing it instead of wherever the parent surface was first touched,
+ * and results cross the interconnect once, during the gather — not on every
+ * cache miss of the compute loop. On single-node machines LOCAL degenerates to
+ * main RAM and changes nothing. This relies on the kernels reading their frame
+ * position from the argument descriptor, never from the interface offset: a
+ * replicate allocated on a non-home node is a fresh buffer starting at offset 0.
+ */
+static struct starpu_codelet cl = {
+  .cpu_funcs = {cpu_func},
+#ifdef STARPU_USE_CUDA
+  .cuda_funcs = {cuda_func},
+  .cuda_flags = {STARPU_CUDA_ASYNC},
+#endif
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model,
+  .name = "mandelbrot_tile",
+};
+
+/*
+ * Separate perfmodel for the adaptive kernel: its cost profile (border-dominated) is
+ * unrelated to the exhaustive kernel's, so the two must not share history entries.
+ */
+static struct starpu_perfmodel tile_model_ms = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile_ms",
+  .footprint = tile_footprint,
+};
+
+static struct starpu_codelet cl_adaptive = {
+  .cpu_funcs = {cpu_func_adaptive},
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model_ms,
+  .name = "mandelbrot_tile_ms",
+};
+
+/*
+ * Reduced- and extended-precision codelets. Each carries its own perfmodel symbol:
+ * the float kernel is roughly twice as fast as the double one and the long-double
+ * kernel several times slower, so sharing history entries would mislead the scheduler.
+ */
+static struct starpu_perfmodel tile_model_f32 = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile_f32",
+  .footprint = tile_footprint,
+};
+
+static struct starpu_codelet cl_f32 = {
+  .cpu_funcs = {cpu_func_f32},
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model_f32,
+  .name = "mandelbrot_tile_f32",
+};
+
+static struct starpu_perfmodel tile_model_f80 = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile_f80",
+  .footprint = tile_footprint,
+};
+
+static struct starpu_codelet cl_f80 = {
+  .cpu_funcs = {cpu_func_f80},
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model_f80,
+  .name = "mandelbrot_tile_f80",
+};
+
+/**
+ * @brief Tile kernel emitting smooth escape values (`cpu_func` with `escape_time_smooth`).
+ *
+ * The boundary supersampling pass is not run in smooth mode: the continuous values
+ * already vary across escape bands, so the equality-based boundary test would refine
+ * nearly every exterior pixel, and downstream coloring interpolates smoothly anyway.
+ *
+ * @param buffers[] StarPU buffers for this tile. `buffers[0]` is the tile of the result
+ *                  mask as a `starpu_matrix_interface`.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+static void cpu_func_smooth(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    for (unsigned i = 0; i < ny; i++) {
+        double imag_part = view.imag_start + (row0 + i) * view.imag_step;
+        for (unsigned j = 0; j < nx; j++) {
+            double real_part = view.real_start + (col0 + j) * view.real_step;
+            val[i * ld + j] = escape_time_smooth(real_part, imag_part, iter);
+        }
+    }
+}
+
+static struct starpu_perfmodel tile_model_smooth = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile_smooth",
+  .footprint = tile_footprint,
+};
+
+static struct starpu_codelet cl_smooth = {
+  .cpu_funcs = {cpu_func_smooth},
+#ifdef STARPU_USE_CUDA
+  .cuda_funcs = {cuda_func_smooth},
+  .cuda_flags = {STARPU_CUDA_ASYNC},
+#endif
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model_smooth,
+  .name = "mandelbrot_tile_smooth",
+};
+
+/*
+ * Perturbation deep-zoom engine. Once the per-pixel step drops below the double ulp,
+ * direct iteration loses every bit of the pixel offsets. Instead of paying extended
+ * precision per pixel, one reference orbit is iterated per frame in long double at the
+ * center pixel and shared with every tile task as a read-only buffer; each pixel then
+ * iterates only its delta from the reference in plain double (delta recurrence
+ * d' = 2*Z*d + d^2 + dc), which stays accurate because the deltas are tiny and exactly
+ * representable. Pixels whose delta iteration degenerates — the orbit approaches zero
+ * faster than the pixel (Pauldelbrot's glitch criterion) or outlives the reference —
+ * are recomputed directly with the long-double kernel, which plays the role of a
+ * per-pixel re-reference.
+ */
+static struct {
+    double *buf;   /* interleaved (Zr, Zi) pairs of the reference orbit */
+    size_t cap;    /* capacity of `buf` in pairs */
+    starpu_data_handle_t handle;
+} ref_orbit;
+
+/**
+ * @brief Iterates one pixel of a deep-zoom tile against the frame's reference orbit.
+ *
+ * @param orbit The reference orbit as interleaved (Zr, Zi) pairs.
+ * @param len The number of valid orbit entries.
+ * @param iter The maximum number of iterations per point.
+ * @param dcr The real part of the pixel's offset from the reference point.
+ * @param dci The imaginary part of the pixel's offset from the reference point.
+ * @param ref_cr The real part of the reference point.
+ * @param ref_ci The imaginary part of the reference point.
+ * @return uint32_t The escape time of the pixel.
+ */
+static uint32_t perturb_point(const double *orbit, int len, int iter, double dcr, double dci,
+                              long double ref_cr, long double ref_ci) {
+    double dr = 0.0, di = 0.0;
+    for (int n = 0; n < iter; n++) {
+        if (n >= len) {
+            // The pixel outlived the reference orbit: re-reference on this pixel.
+            return escape_time_f80(ref_cr + (long double)dcr, ref_ci + (long double)dci, iter);
+        }
+        double Zr = orbit[2 * n];
+        double Zi = orbit[2 * n + 1];
+        double zr = Zr + dr;
+        double zi = Zi + di;
+        double mag = zr * zr + zi * zi;
+        if (mag > 4.0) {
+            // The escape test here sees z_n before the update; the direct kernels
+            // test after theirs and report n for an escape at z_{n+1}. Shift by one
+            // so both conventions agree and the glitch/exhaustion fallbacks (which
+            // call the direct kernel) blend in seamlessly. n == 0 cannot escape
+            // (z_0 = 0), but guard it rather than rely on that.
+            return n > 0 ? (uint32_t)(n - 1) : 0;
+        }
+        // Glitch detection: the full orbit passing much closer to zero than the
+        // reference means the delta has absorbed all significant digits.
+        if (mag < 1e-6 * (Zr * Zr + Zi * Zi)) {
+            return escape_time_f80(ref_cr + (long double)dcr, ref_ci + (long double)dci, iter);
+        }
+        double nr = 2.0 * (Zr * dr - Zi * di) + (dr * dr - di * di) + dcr;
+        double ni = 2.0 * (Zr * di + Zi * dr) + 2.0 * dr * di + dci;
+        dr = nr;
+        di = ni;
+    }
+    return (uint32_t)iter;
+}
+
+/**
+ * @brief Perturbation variant of `cpu_func` for deep zooms.
+ *
+ * Receives the tile as `buffers[0]` and the frame's reference orbit as a read-only
+ * vector in `buffers[1]`. Pixel offsets from the reference are derived from integer
+ * pixel distances times the per-pixel steps, so they are exact regardless of zoom
+ * depth. The supersampling pass is skipped here: its double-precision sample offsets
+ * are below the representable resolution at these zooms.
+ *
+ * @param buffers[] The tile of the result mask and the reference orbit.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+void cpu_func_perturb(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    struct starpu_vector_interface *orbit_if = buffers[1];
+    const double *orbit = (const double *)STARPU_VECTOR_GET_PTR(orbit_if);
+
+    for (unsigned i = 0; i < ny; i++) {
+        double dci = ((long)(row0 + i) - args->ref_row) * view.imag_step;
+        for (unsigned j = 0; j < nx; j++) {
+            double dcr = ((long)(col0 + j) - args->ref_col) * view.real_step;
+            val[i * ld + j] = perturb_point(orbit, args->ref_len, iter, dcr, dci,
+                                            args->ref_cr, args->ref_ci);
+        }
+    }
+}
+
+static struct starpu_perfmodel tile_model_perturb = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile_perturb",
+  .footprint = tile_footprint,
+};
+
+static struct starpu_codelet cl_perturb = {
+  .cpu_funcs = {cpu_func_perturb},
+  .nbuffers = 2,
+  .modes = {STARPU_W, STARPU_R},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL, STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model_perturb,
+  .name = "mandelbrot_tile_perturb",
+};
+
+/**
+ * @brief Computes the frame's reference orbit and fills the perturbation fields of `args`.
+ *
+ * Iterates the center pixel of the frame in long double, storing each orbit value
+ * (rounded to double — the orbit itself is O(1) in magnitude, only its computation
+ * needs the extra digits) into a shared buffer registered as a StarPU vector. The
+ * buffer is reused across frames and only grows when the iteration budget does.
+ *
+ * @param view The viewport describing the frame.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param iter The maximum number of iterations per point.
+ * @param args The frame's argument descriptor, receiving the reference metadata.
+ * @return int Returns 0 on success, or -1 if the orbit buffer cannot be allocated.
+ */
+static int prepare_reference(const struct viewport *view, unsigned rows, unsigned cols,
+                             int iter, struct tile_args *args) {
+    if ((size_t)iter > ref_orbit.cap) {
+        if (ref_orbit.buf != NULL) {
+            starpu_data_unregister(ref_orbit.handle);
+            mb_free(ref_orbit.buf, ref_orbit.cap * 2 * sizeof(double));
+        }
+        ref_orbit.buf = mb_alloc((size_t)iter * 2 * sizeof(double));
+        if (ref_orbit.buf == NULL) {
+            ref_orbit.cap = 0;
+            return -1;
+        }
+        ref_orbit.cap = (size_t)iter;
+        starpu_vector_data_register(&ref_orbit.handle, STARPU_MAIN_RAM,
+                                    (uintptr_t)ref_orbit.buf, (size_t)iter * 2, sizeof(double));
+    }
+
+    args->ref_row = (long)(rows / 2);
+    args->ref_col = (long)(cols / 2);
+    // The reference point is the double-rounded center coordinate; the deltas are
+    // taken relative to exactly this value, so no precision is lost by the rounding.
+    args->ref_cr = (long double)(view->real_start + (cols / 2) * view->real_step);
+    args->ref_ci = (long double)(view->imag_start + (rows / 2) * view->imag_step);
+
+    starpu_data_acquire(ref_orbit.handle, STARPU_W);
+    long double zr = 0.0L, zi = 0.0L;
+    int len = iter;
+    for (int n = 0; n < iter; n++) {
+        ref_orbit.buf[2 * n] = (double)zr;
+        ref_orbit.buf[2 * n + 1] = (double)zi;
+        long double nzr = zr * zr - zi * zi + args->ref_cr;
+        long double nzi = 2.0L * zr * zi + args->ref_ci;
+        zr = nzr;
+        zi = nzi;
+        if (zr * zr + zi * zi > 4.0L) {
+            len = n + 1;
+            break;
+        }
+    }
+    args->ref_len = len;
+    starpu_data_release(ref_orbit.handle);
+    return 0;
+}
+
+/**
+ * @brief Releases the reference orbit buffer. Must be called before `starpu_shutdown`.
+ */
+void deep_cache_drop(void) {
+    if (ref_orbit.buf != NULL) {
+        starpu_data_unregister(ref_orbit.handle);
+        mb_free(ref_orbit.buf, ref_orbit.cap * 2 * sizeof(double));
+        ref_orbit.buf = NULL;
+        ref_orbit.cap = 0;
+    }
+}
+
+/*
+ * Progressive rendering. An interactive operator judges framing from a rough image
+ * long before the frame is exact, so progressive mode restructures submission for
+ * perceived latency instead of throughput: tiles are submitted along the Z-order
+ * curve (early completions sample the whole frame instead of its top rows), and a
+ * cheap preview pass computing every PREVIEW_STRIDE-th pixel runs over the frame
+ * before the exact pass refines it. Task completions are reported through an
+ * optional callback so a front-end can display the surface as it converges.
+ */
+#define PREVIEW_STRIDE 8
+
+/**
+ * @brief Coarse preview kernel: computes every `PREVIEW_STRIDE`-th pixel of a tile.
+ *
+ * Samples the tile on a `PREVIEW_STRIDE`-spaced grid and replicates each sample over
+ * its block, producing a blocky but correctly-framed image for about 1/64th of the
+ * exhaustive kernel's work. The exact pass overwrites the tile afterwards; sequential
+ * consistency on the tile handle orders the two.
+ *
+ * @param buffers[] StarPU buffers for this tile. `buffers[0]` is the tile of the result
+ *                  mask as a `starpu_matrix_interface`.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+static void cpu_func_coarse(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = cl_arg;
+    struct viewport view = args->view;
+    int iter = args->iter;
+
+    struct starpu_matrix_interface *mask = buffers[0];
+    uint32_t *val = (uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    unsigned row0 = args->row0;
+    unsigned col0 = args->col0;
+
+    for (unsigned i = 0; i < ny; i += PREVIEW_STRIDE) {
+        unsigned bh = i + PREVIEW_STRIDE <= ny ? PREVIEW_STRIDE : ny - i;
+        double imag_part = view.imag_start + (row0 + i) * view.imag_step;
+        for (unsigned j = 0; j < nx; j += PREVIEW_STRIDE) {
+            unsigned bw = j + PREVIEW_STRIDE <= nx ? PREVIEW_STRIDE : nx - j;
+            double real_part = view.real_start + (col0 + j) * view.real_step;
+            uint32_t v = escape_time(real_part + imag_part * I, iter);
+            if (args->smooth) {
+                v <<= SMOOTH_BITS; // match the exact pass's fixed-point scale
+            }
+            for (unsigned bi = 0; bi < bh; bi++) {
+                for (unsigned bj = 0; bj < bw; bj++) {
+                    val[(i + bi) * ld + (j + bj)] = v;
+                }
+            }
+        }
+    }
+}
+
+static struct starpu_perfmodel tile_model_coarse = {
+  .type = STARPU_HISTORY_BASED,
+  .symbol = "mandelbrot_tile_coarse",
+  .footprint = tile_footprint,
+};
+
+static struct starpu_codelet cl_coarse = {
+  .cpu_funcs = {cpu_func_coarse},
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .specific_nodes = 1,
+  .nodes = {STARPU_SPECIFIC_NODE_LOCAL},
+  .model = &tile_model_coarse,
+  .name = "mandelbrot_tile_coarse",
+};
+
+/* Whether frames are submitted progressively (Z-order tiles plus preview pass). */
+static int progressive_mode = 0;
+
+/**
+ * @brief Enables or disables progressive submission for subsequent frames.
+ *
+ * @param enable Non-zero for Z-order submission with a coarse preview pass, 0 for
+ *               plain row-major submission.
+ */
+void set_progressive_mode(int enable) {
+    progressive_mode = enable;
+}
+
+/*
+ * Completion callback registered by the front-end. Tile tasks encode their frame
+ * position into the callback argument (tile index shifted left once, preview flag in
+ * the low bit); the trampoline decodes it with the tile-column count of the frame
+ * being submitted.
+ */
+static void (*progress_cb)(unsigned tile_row, unsigned tile_col, int preview, void *arg);
+static void *progress_arg;
+static unsigned progress_tiles_x;
+
+/**
+ * @brief Registers a callback invoked as each tile task of a frame completes.
+ *
+ * The callback runs in StarPU callback context (a worker thread, between tasks), so it
+ * must not block or submit synchronous work; a front-end typically records the dirty
+ * tile rectangle and redraws from its own thread. Preview completions are reported
+ * with `preview` set. Pass NULL to unregister.
+ *
+ * @param cb The function to call with the completed tile's grid position.
+ * @param arg Opaque pointer handed through to every invocation.
+ */
+void set_progress_callback(void (*cb)(unsigned tile_row, unsigned tile_col, int preview,
+                                      void *arg),
+                           void *arg) {
+    progress_cb = cb;
+    progress_arg = arg;
+}
+
+/** @brief Task completion trampoline: decodes the tile position and calls the callback. */
+static void progress_done(void *enc) {
+    if (progress_cb == NULL) {
+        return;
+    }
+    uintptr_t code = (uintptr_t)enc;
+    unsigned index = (unsigned)(code >> 1);
+    progress_cb(index / progress_tiles_x, index % progress_tiles_x, (int)(code & 1),
+                progress_arg);
+}
+
+/**
+ * @brief Extracts the even-position bits of a Morton code (one axis of the Z-order curve).
+ *
+ * @param code The Morton code with the axis of interest in its even bit positions.
+ * @return unsigned The axis coordinate.
+ */
+static unsigned morton_axis(unsigned long code) {
+    unsigned x = (unsigned)code & 0x55555555u;
+    x = (x | (x >> 1)) & 0x33333333u;
+    x = (x | (x >> 2)) & 0x0f0f0f0fu;
+    x = (x | (x >> 4)) & 0x00ff00ffu;
+    x = (x | (x >> 8)) & 0x0000ffffu;
+    return x;
+}
+
+/*
+ * Per-frame escape-count statistics, accumulated as a StarPU reduction. The buffer is
+ * a vector of uint64 with one histogram bin per escape count (0..iter) followed by two
+ * extra slots for the minimum and maximum count of the frame. Every tile contributes
+ * through a small read-only pass over its finished results (the tile is still hot in
+ * cache at that point), accessed with STARPU_REDUX so each worker accumulates into a
+ * private copy and StarPU merges the copies when the frame completes — the histogram
+ * is ready the moment the tasks are, with no extra pass over the full surface.
+ */
+static struct {
+    uint64_t *buf;
+    size_t len;    /* iter + 3 elements: bins, then min, then max */
+    starpu_data_handle_t handle;
+    int enabled;
+} frame_stats;
+
+/** @brief Reduction initializer: empty histogram, min/max at their identities. */
+void stats_init_func(void *buffers[], void *cl_arg) {
+    (void)cl_arg;
+    struct starpu_vector_interface *v = buffers[0];
+    uint64_t *s = (uint64_t *)STARPU_VECTOR_GET_PTR(v);
+    size_t n = STARPU_VECTOR_GET_NX(v);
+    memset(s, 0, n * sizeof(uint64_t));
+    s[n - 2] = UINT64_MAX; /* min */
+}
+
+/** @brief Reduction merge: adds the bins and folds the min/max of two partial results. */
+void stats_redux_func(void *buffers[], void *cl_arg) {
+    (void)cl_arg;
+    uint64_t *dst = (uint64_t *)STARPU_VECTOR_GET_PTR((struct starpu_vector_interface *)buffers[0]);
+    const uint64_t *src =
+        (const uint64_t *)STARPU_VECTOR_GET_PTR((struct starpu_vector_interface *)buffers[1]);
+    size_t n = STARPU_VECTOR_GET_NX((struct starpu_vector_interface *)buffers[0]);
+    for (size_t i = 0; i < n - 2; i++) {
+        dst[i] += src[i];
+    }
+    dst[n - 2] = src[n - 2] < dst[n - 2] ? src[n - 2] : dst[n - 2];
+    dst[n - 1] = src[n - 1] > dst[n - 1] ? src[n - 1] : dst[n - 1];
+}
+
+static struct starpu_codelet stats_init_cl = {
+  .cpu_funcs = {stats_init_func},
+  .nbuffers = 1,
+  .modes = {STARPU_W},
+  .name = "mandelbrot_stats_init",
+};
+
+static struct starpu_codelet stats_redux_cl = {
+  .cpu_funcs = {stats_redux_func},
+  .nbuffers = 2,
+  .modes = {STARPU_RW, STARPU_R},
+  .name = "mandelbrot_stats_redux",
+};
+
+/**
+ * @brief Accumulates one finished tile into the frame statistics.
+ *
+ * @param buffers[] The tile of the result mask (read-only) and the worker's private
+ *                  copy of the statistics vector.
+ * @param cl_arg Pointer to the tile's `struct tile_args` descriptor.
+ */
+void stats_tile_func(void *buffers[], void *cl_arg) {
+    const struct tile_args *args = cl_arg;
+    struct starpu_matrix_interface *mask = buffers[0];
+    const uint32_t *val = (const uint32_t *)STARPU_MATRIX_GET_PTR(mask);
+    unsigned nx = STARPU_MATRIX_GET_NX(mask);
+    unsigned ny = STARPU_MATRIX_GET_NY(mask);
+    unsigned ld = STARPU_MATRIX_GET_LD(mask);
+    uint64_t *s = (uint64_t *)STARPU_VECTOR_GET_PTR((struct starpu_vector_interface *)buffers[1]);
+    size_t n = (size_t)args->iter + 3;
+
+    for (unsigned i = 0; i < ny; i++) {
+        for (unsigned j = 0; j < nx; j++) {
+            // Smooth-mode values are binned by their integer part, so the
+            // histogram keeps one bin per iteration band in either mode.
+            uint64_t count = args->smooth ? val[i * ld + j] >> SMOOTH_BITS
+                                          : val[i * ld + j];
+            s[count]++;
+            s[n - 2] = count < s[n - 2] ? count : s[n - 2];
+            s[n - 1] = count > s[n - 1] ? count : s[n - 1];
+        }
+    }
+}
+
+static struct starpu_codelet stats_cl = {
+  .cpu_funcs = {stats_tile_func},
+  .nbuffers = 2,
+  .modes = {STARPU_R, STARPU_REDUX},
+  .name = "mandelbrot_stats",
+};
+
+/**
+ * @brief Enables or disables statistics accumulation for subsequent frames.
+ *
+ * @param enable Non-zero to accumulate the escape-count histogram and min/max per frame.
+ */
+void set_stats_mode(int enable) {
+    frame_stats.enabled = enable;
+}
+
+/**
+ * @brief (Re)allocates and registers the statistics buffer for an iteration budget.
+ *
+ * @param iter The maximum number of iterations per point.
+ * @return int Returns 0 on success, or -1 if the buffer cannot be allocated.
+ */
+static int prepare_stats(int iter) {
+    size_t len = (size_t)iter + 3;
+    if (frame_stats.buf == NULL || frame_stats.len != len) {
+        if (frame_stats.buf != NULL) {
+            starpu_data_unregister(frame_stats.handle);
+            mb_free(frame_stats.buf, frame_stats.len * sizeof(uint64_t));
+        }
+        frame_stats.buf = mb_alloc(len * sizeof(uint64_t));
+        if (frame_stats.buf == NULL) {
+            frame_stats.len = 0;
+            return -1;
+        }
+        frame_stats.len = len;
+        starpu_vector_data_register(&frame_stats.handle, STARPU_MAIN_RAM,
+                                    (uintptr_t)frame_stats.buf, len, sizeof(uint64_t));
+        starpu_data_set_reduction_methods(frame_stats.handle, &stats_redux_cl, &stats_init_cl);
+    }
+
+    // The reduction identity only seeds the per-worker copies; the main buffer
+    // itself must be reset so frames do not accumulate into each other.
+    starpu_data_acquire(frame_stats.handle, STARPU_W);
+    memset(frame_stats.buf, 0, len * sizeof(uint64_t));
+    frame_stats.buf[len - 2] = UINT64_MAX;
+    starpu_data_release(frame_stats.handle);
+    return 0;
+}
+
+/**
+ * @brief Writes the finished frame's escape-count histogram as CSV.
+ *
+ * One `count,pixels` line per non-empty bin, preceded by comment lines carrying the
+ * frame's minimum and maximum escape count. Only meaningful after `finish_frame` of a
+ * frame rendered with statistics enabled (`set_stats_mode`).
+ *
+ * @param path The file to create or overwrite.
+ * @return int Returns 0 on success, or -1 if statistics are missing or the write fails.
+ */
+int write_histogram(const char *path) {
+    if (frame_stats.buf == NULL) {
+        return -1;
+    }
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    starpu_data_acquire(frame_stats.handle, STARPU_R);
+    size_t n = frame_stats.len;
+    fprintf(f, "# min %llu\n# max %llu\n",
+            (unsigned long long)frame_stats.buf[n - 2],
+            (unsigned long long)frame_stats.buf[n - 1]);
+    for (size_t i = 0; i < n - 2; i++) {
+        if (frame_stats.buf[i] != 0) {
+            fprintf(f, "%zu,%llu\n", i, (unsigned long long)frame_stats.buf[i]);
+        }
+    }
+    starpu_data_release(frame_stats.handle);
+    if (fclose(f) != 0) {
+        perror(path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Releases the statistics buffer. Must be called before `starpu_shutdown`.
+ */
+void stats_drop(void) {
+    if (frame_stats.buf != NULL) {
+        starpu_data_unregister(frame_stats.handle);
+        mb_free(frame_stats.buf, frame_stats.len * sizeof(uint64_t));
+        frame_stats.buf = NULL;
+        frame_stats.len = 0;
+    }
+}
+
+/*
+ * Precision thresholds on the per-pixel step. Float carries a 24-bit mantissa, so with
+ * coordinates of magnitude ~2 its ulp sits around 2e-7; steps of 1e-4 and above leave
+ * three orders of magnitude of headroom and the float kernel matches the double one on
+ * all but the occasional boundary pixel, where a near-escape orbit rounds to a count
+ * one off. Symmetrically, double quantization becomes visible once the step approaches
+ * its ~2e-16 ulp, so below 1e-13 the long-double kernel takes over.
+ */
+#define F32_MIN_STEP 1e-4
+#define F64_MIN_STEP 1e-13
+
+/* Whether select_cpu_kernel installed a SIMD kernel into the default codelet. */
+static int simd_selected = 0;
+
+/**
+ * @brief Picks the cheapest precision whose output is visually equivalent at this zoom.
+ *
+ * The decision is made on the finer of the two per-pixel steps: shallow zooms run the
+ * float kernel, deep zooms the long-double one, everything in between the default
+ * double codelet. The float kernel only exists in scalar CPU form, so it is preferred
+ * only when the double codelet would run scalar CPU code too — displacing the SIMD or
+ * CUDA implementations the default codelet carries would trade their 4-8x for its 2x.
+ *
+ * @param view The viewport describing the frame.
+ * @return struct starpu_codelet* The codelet to submit the frame's tiles with.
+ */
+static struct starpu_codelet *precision_codelet(const struct viewport *view) {
+    double step = fabs(view->real_step) < fabs(view->imag_step)
+                      ? fabs(view->real_step)
+                      : fabs(view->imag_step);
+    if (step >= F32_MIN_STEP && !simd_selected && cl.cuda_funcs[0] == NULL) {
+        return &cl_f32;
+    }
+    if (step < F64_MIN_STEP) {
+        return &cl_f80;
+    }
+    return &cl;
+}
+
+/* Codelet used for tile tasks; submit_frame picks the adaptive one when enabled. */
+static struct starpu_codelet *active_cl = &cl;
+
+/**
+ * @brief Enables or disables the Mariani–Silver adaptive renderer.
+ *
+ * When enabled, subsequent frames are rendered with `cpu_func_adaptive`, which fills
+ * uniform rectangles from their borders instead of iterating every pixel.
+ *
+ * @param enable Non-zero to use the adaptive kernel, 0 for the exhaustive one.
+ */
+void set_adaptive_mode(int enable) {
+    active_cl = enable ? &cl_adaptive : &cl;
+}
+
+/* Whether tile tasks should run the boundary supersampling pass. */
+static int ssaa_mode = 0;
+
+/**
+ * @brief Enables or disables boundary supersampling for subsequent frames.
+ *
+ * When enabled, every tile kernel follows its single-sample pass with `refine_tile`,
+ * which re-samples only the pixels sitting on escape-class boundaries.
+ *
+ * @param enable Non-zero to supersample boundary pixels, 0 for single sampling.
+ */
+void set_supersample_mode(int enable) {
+    ssaa_mode = enable;
+}
+
+/* Whether the surface holds 24.8 fixed-point smooth escape values. */
+static int smooth_mode = 0;
+
+/**
+ * @brief Enables or disables smooth (continuous) escape values for subsequent frames.
+ *
+ * When enabled, frames render with `cpu_func_smooth` and the surface holds 24.8
+ * fixed-point smooth iteration values (see `SMOOTH_BITS`) instead of integer escape
+ * counts. Smooth mode takes precedence over the adaptive and precision-specialized
+ * kernels, which produce integer counts only.
+ *
+ * @param enable Non-zero for smooth escape values, 0 for integer escape counts.
+ */
+void set_smooth_mode(int enable) {
+    smooth_mode = enable;
+}
+
+/**
+ * @brief Returns the codelet the tiles of a frame should be submitted with.
+ *
+ * Resolves the active rendering mode and the zoom-based precision selection in one
+ * place, so alternative frame drivers (the MPI renderer) submit tiles with exactly
+ * the same codelet `submit_frame` would pick.
+ *
+ * @param view The viewport describing the frame.
+ * @return struct starpu_codelet* The codelet to submit the frame's tiles with.
+ */
+struct starpu_codelet *frame_codelet(const struct viewport *view) {
+    if (smooth_mode) {
+        return &cl_smooth;
+    }
+    return active_cl == &cl ? precision_codelet(view) : active_cl;
+}
+
+/**
+ * @brief Picks the fastest tile kernel the running CPU supports.
+ *
+ * The codelet is declared with the portable scalar `cpu_func`; at startup this function
+ * probes the CPU with `__builtin_cpu_supports` (which reads CPUID once and caches it) and
+ * swaps in the AVX-512 or AVX2 tile kernel when the corresponding instructions are
+ * available. On non-x86 builds the scalar kernel is kept as-is.
+ */
+void select_cpu_kernel(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx512f")) {
+        cl.cpu_funcs[0] = cpu_func_avx512;
+        simd_selected = 1;
+    } else if (__builtin_cpu_supports("avx2")) {
+        cl.cpu_funcs[0] = cpu_func_avx2;
+        simd_selected = 1;
+    }
+#endif
+}
+
+/**
+ * @brief Returns the CPU tile kernels of this build, for the microbenchmark harness.
+ *
+ * Every entry honors the same contract as `cpu_func`: it renders one tile of the
+ * result mask described by a `starpu_matrix_interface` from a `struct tile_args`
+ * descriptor, so the harness can drive each kernel directly on a fabricated
+ * interface without going through the scheduler. The SIMD variants appear only
+ * when the running CPU supports them, mirroring `select_cpu_kernel`. The
+ * perturbation kernel is deliberately absent — it reads a per-frame reference
+ * orbit buffer and is exercised through the frame path instead.
+ *
+ * @param count Receives the number of entries.
+ * @return const struct cpu_kernel* The kernel table.
+ */
+const struct cpu_kernel *cpu_kernels(unsigned *count) {
+    static struct cpu_kernel table[8];
+    unsigned n = 0;
+    table[n++] = (struct cpu_kernel){ .name = "scalar", .func = cpu_func };
+    table[n++] = (struct cpu_kernel){ .name = "f32", .func = cpu_func_f32 };
+    table[n++] = (struct cpu_kernel){ .name = "f80", .func = cpu_func_f80 };
+    table[n++] = (struct cpu_kernel){ .name = "adaptive", .func = cpu_func_adaptive };
+    table[n++] = (struct cpu_kernel){ .name = "smooth", .func = cpu_func_smooth };
+    table[n++] = (struct cpu_kernel){ .name = "coarse", .func = cpu_func_coarse };
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) {
+        table[n++] = (struct cpu_kernel){ .name = "avx2", .func = cpu_func_avx2 };
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        table[n++] = (struct cpu_kernel){ .name = "avx512", .func = cpu_func_avx512 };
+    }
+#endif
+    *count = n;
+    return table;
+}
+
+/*
+ * Previous-frame cache for interactive pans. Keyed by the full rendering
+ * configuration — grid size, per-pixel steps (center and zoom) and iteration
+ * budget — it keeps a snapshot of the last rendered mask and its viewport.
+ * The snapshot doubles as the cost model for tile priorities (`tile_priorities`).
+ */
+static struct {
+    uint32_t *mask;
+    size_t size;
+    struct viewport view;
+    int iter;
+    unsigned rows;
+    unsigned cols;
+    int valid;
+} pan_cache;
+
+/* Per-tile priority scratch, grown on demand (tile_priorities). */
+static struct {
+    uint64_t *cost;
+    int *prio;
+    size_t cap;
+} tile_prio;
+
+/**
+ * @brief Estimates per-tile priorities for a frame from the previous frame's surface.
+ *
+ * With uniform priorities the schedulers frequently run the cheap exterior tiles
+ * first, and the frame ends with a lone worker grinding the cardioid tiles while the
+ * rest idle. Consecutive animation frames are nearly identical, so the previous
+ * frame's escape counts (the pan-cache snapshot) are a good relative cost model for
+ * the next one: a tile's work is roughly the sum of its pixels' iteration counts.
+ * Each tile's count sum is taken on a 4x4-decimated sample grid (1/16th of the pixels
+ * — ample for ranking) and mapped linearly onto the scheduler's priority range, so
+ * the expensive tiles enter the queues first and the frame tail shrinks toward the
+ * theoretical minimum. The snapshot only needs matching dimensions: a changed zoom or
+ * budget shifts all costs together and leaves the ranking intact.
+ *
+ * @param tiles_y The number of tile rows of the frame.
+ * @param tiles_x The number of tile columns of the frame.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @return const int* One priority per tile in row-major order, or NULL to submit
+ *         with uniform priorities (no usable snapshot, or a flat frame).
+ */
+static const int *tile_priorities(unsigned tiles_y, unsigned tiles_x,
+                                  unsigned rows, unsigned cols) {
+    if (!pan_cache.valid || pan_cache.rows != rows || pan_cache.cols != cols) {
+        return NULL;
+    }
+    int prio_min = starpu_sched_get_min_priority();
+    int prio_max = starpu_sched_get_max_priority();
+    if (prio_max <= prio_min) {
+        return NULL; // the scheduler ignores priorities anyway
+    }
+
+    size_t ntiles = (size_t)tiles_y * tiles_x;
+    if (ntiles > tile_prio.cap) {
+        free(tile_prio.cost);
+        free(tile_prio.prio);
+        tile_prio.cost = malloc(ntiles * sizeof(*tile_prio.cost));
+        tile_prio.prio = malloc(ntiles * sizeof(*tile_prio.prio));
+        if (tile_prio.cost == NULL || tile_prio.prio == NULL) {
+            free(tile_prio.cost);
+            free(tile_prio.prio);
+            tile_prio.cost = NULL;
+            tile_prio.prio = NULL;
+            tile_prio.cap = 0;
+            return NULL;
+        }
+        tile_prio.cap = ntiles;
+    }
+
+    uint64_t minc = UINT64_MAX, maxc = 0;
+    for (unsigned ty = 0; ty < tiles_y; ty++) {
+        unsigned tr1 = (ty + 1) * TILE_ROWS < rows ? (ty + 1) * TILE_ROWS : rows;
+        for (unsigned tx = 0; tx < tiles_x; tx++) {
+            unsigned tc1 = (tx + 1) * TILE_COLS < cols ? (tx + 1) * TILE_COLS : cols;
+            uint64_t c = 0;
+            for (unsigned i = ty * TILE_ROWS; i < tr1; i += 4) {
+                for (unsigned j = tx * TILE_COLS; j < tc1; j += 4) {
+                    c += pan_cache.mask[(size_t)i * cols + j];
+                }
+            }
+            tile_prio.cost[(size_t)ty * tiles_x + tx] = c;
+            minc = c < minc ? c : minc;
+            maxc = c > maxc ? c : maxc;
+        }
+    }
+    if (maxc == minc) {
+        return NULL; // flat frame, nothing to order
+    }
+
+    for (size_t t = 0; t < ntiles; t++) {
+        tile_prio.prio[t] = prio_min + (int)((tile_prio.cost[t] - minc) *
+                                             (uint64_t)(prio_max - prio_min) /
+                                             (maxc - minc));
+    }
+    return tile_prio.prio;
+}
+
+/**
+ * @brief Partitions the mask and submits one tile task per block of the frame.
+ *
+ * The mask handle is partitioned into `TILE_ROWS x TILE_COLS` tiles with block filters
+ * and one task per tile is submitted with the frame's viewport and iteration budget.
+ * Submission is asynchronous: the tasks execute in the background until
+ * `finish_frame` is called. Keeping submission and completion separate lets callers
+ * (the benchmark harness in particular) time the two stages independently.
+ *
+ * @param mask_handle The registered handle of the escape-time surface.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ * @return unsigned The number of tasks submitted.
+ */
+/**
+ * @brief Partitions the mask and submits tile tasks, skipping tiles inside a valid region.
+ *
+ * Shared submission path of `submit_frame` and the pan cache: tiles lying entirely
+ * inside the rectangle `[keep_r0, keep_r1) x [keep_c0, keep_c1)` already hold correct
+ * results (translated from the previous frame) and get no task. An empty rectangle
+ * submits every tile.
+ *
+ * @param mask_handle The registered handle of the escape-time surface.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ * @param keep_r0 The first row of the already-valid rectangle.
+ * @param keep_r1 One past the last row of the already-valid rectangle.
+ * @param keep_c0 The first column of the already-valid rectangle.
+ * @param keep_c1 One past the last column of the already-valid rectangle.
+ * @return unsigned The number of tasks submitted.
+ */
+static unsigned submit_tiles(starpu_data_handle_t mask_handle, unsigned rows, unsigned cols,
+                             const struct viewport *view, int iter,
+                             unsigned keep_r0, unsigned keep_r1,
+                             unsigned keep_c0, unsigned keep_c1) {
+    // Split the mask into a grid of tiles; each task covers exactly one tile.
+    unsigned tiles_y = (rows + TILE_ROWS - 1) / TILE_ROWS;
+    unsigned tiles_x = (cols + TILE_COLS - 1) / TILE_COLS;
+    struct starpu_data_filter rows_filter = {
+        .filter_func = starpu_matrix_filter_vertical_block,
+        .nchildren = tiles_y,
+    };
+    struct starpu_data_filter cols_filter = {
+        .filter_func = starpu_matrix_filter_block,
+        .nchildren = tiles_x,
+    };
+    starpu_data_map_filters(mask_handle, 2, &rows_filter, &cols_filter);
+
+    /*
+     * One preallocated descriptor per tile, from an arena reused across frames
+     * (a frame is always finished before the next one is submitted). The tiles
+     * differ only in their frame position; everything else is stamped from a
+     * template. Passing the descriptors with STARPU_CL_ARGS_NFREE hands each
+     * task a pointer into the arena instead of malloc'ing and memcpy'ing a
+     * fresh STARPU_VALUE blob per task, which takes the allocator out of the
+     * submission path entirely.
+     */
+    static struct tile_args *frame_args;
+    static size_t frame_args_cap;
+    size_t ntiles = (size_t)tiles_y * tiles_x;
+    if (ntiles > frame_args_cap) {
+        free(frame_args);
+        frame_args = malloc(ntiles * sizeof(*frame_args));
+        if (frame_args == NULL) {
+            frame_args_cap = 0;
+            return 0;
+        }
+        frame_args_cap = ntiles;
+    }
+
+    struct tile_args tpl;
+    memset(&tpl, 0, sizeof(tpl));
+    tpl.view = *view;
+    tpl.iter = iter;
+    tpl.ssaa = ssaa_mode;
+    tpl.smooth = smooth_mode;
+
+    struct starpu_codelet *codelet = frame_codelet(view);
+    /*
+     * Deep zoom: swap the direct long-double kernel for the perturbation engine
+     * when a reference orbit can be prepared. (The MPI driver keeps the direct
+     * kernel returned by frame_codelet, since its strips carry no orbit buffer.)
+     */
+    if (codelet == &cl_f80 && prepare_reference(view, rows, cols, iter, &tpl) == 0) {
+        codelet = &cl_perturb;
+    }
+
+    for (unsigned ty = 0; ty < tiles_y; ty++) {
+        for (unsigned tx = 0; tx < tiles_x; tx++) {
+            struct tile_args *a = &frame_args[(size_t)ty * tiles_x + tx];
+            *a = tpl;
+            a->row0 = ty * TILE_ROWS;
+            a->col0 = tx * TILE_COLS;
+        }
+    }
+
+    int stats = frame_stats.enabled && prepare_stats(iter) == 0;
+
+    /*
+     * Tile visiting order. Row-major by default; progressive mode walks the Z-order
+     * curve of the smallest enclosing power-of-two square instead (out-of-range
+     * codes are skipped), so the first tasks to complete are spread over the whole
+     * frame rather than concentrated in its top rows. The preview pass is submitted
+     * in full before the exact pass: it is about 1/64th of the frame's work, so the
+     * whole coarse image resolves before the exact tiles start landing. Extended
+     * precision gets no preview — the coarse kernel iterates in double, which is
+     * exactly what those zoom depths cannot use.
+     */
+    unsigned side = 1;
+    while (side < tiles_y || side < tiles_x) {
+        side <<= 1;
+    }
+    unsigned long ncodes = progressive_mode ? (unsigned long)side * side
+                                            : (unsigned long)tiles_y * tiles_x;
+    int preview = progressive_mode && codelet != &cl_f80 && codelet != &cl_perturb;
+    progress_tiles_x = tiles_x;
+
+    // Cost-ordered priorities from the previous frame's snapshot; preview tasks
+    // outrank everything so the coarse image resolves before the exact tiles.
+    const int *prio = tile_priorities(tiles_y, tiles_x, rows, cols);
+    int prio_max = starpu_sched_get_max_priority();
+
+    unsigned tasks = 0;
+    for (int pass = preview ? 0 : 1; pass < 2; pass++) {
+        struct starpu_codelet *pass_cl = pass == 0 ? &cl_coarse : codelet;
+        for (unsigned long k = 0; k < ncodes; k++) {
+            unsigned ty, tx;
+            if (progressive_mode) {
+                tx = morton_axis(k);
+                ty = morton_axis(k >> 1);
+                if (ty >= tiles_y || tx >= tiles_x) {
+                    continue;
+                }
+            } else {
+                ty = (unsigned)(k / tiles_x);
+                tx = (unsigned)(k % tiles_x);
+            }
+            unsigned tr0 = ty * TILE_ROWS;
+            unsigned tr1 = tr0 + TILE_ROWS < rows ? tr0 + TILE_ROWS : rows;
+            unsigned tc0 = tx * TILE_COLS;
+            unsigned tc1 = tc0 + TILE_COLS < cols ? tc0 + TILE_COLS : cols;
+            starpu_data_handle_t tile = starpu_data_get_sub_data(mask_handle, 2, ty, tx);
+            int kept = tr0 >= keep_r0 && tr1 <= keep_r1 && tc0 >= keep_c0 && tc1 <= keep_c1;
+            if (!kept) {
+                void *enc = (void *)((((uintptr_t)ty * tiles_x + tx) << 1) | (pass == 0));
+                int task_prio = pass == 0 ? prio_max
+                                : prio != NULL ? prio[(size_t)ty * tiles_x + tx]
+                                               : STARPU_DEFAULT_PRIO;
+                struct tile_args *targs = &frame_args[(size_t)ty * tiles_x + tx];
+                if (pass_cl == &cl_perturb) {
+                    starpu_task_insert(
+                        pass_cl,
+                        STARPU_W, tile,
+                        STARPU_R, ref_orbit.handle,
+                        STARPU_CL_ARGS_NFREE, targs, sizeof(*targs),
+                        STARPU_PRIORITY, task_prio,
+                        STARPU_CALLBACK, progress_done,
+                        STARPU_CALLBACK_ARG_NFREE, enc,
+                        0);
+                } else {
+                    starpu_task_insert(
+                        pass_cl,
+                        STARPU_W, tile,
+                        STARPU_CL_ARGS_NFREE, targs, sizeof(*targs),
+                        STARPU_PRIORITY, task_prio,
+                        STARPU_CALLBACK, progress_done,
+                        STARPU_CALLBACK_ARG_NFREE, enc,
+                        0);
+                }
+                tasks++;
+            }
+            // Statistics cover every tile (pan-reused ones included); the read
+            // dependency orders each stats task after its tile's render task.
+            if (pass == 1 && stats) {
+                starpu_task_insert(
+                    &stats_cl,
+                    STARPU_R, tile,
+                    STARPU_REDUX, frame_stats.handle,
+                    STARPU_CL_ARGS_NFREE, &frame_args[(size_t)ty * tiles_x + tx],
+                    sizeof(struct tile_args),
+                    0);
+            }
+        }
+    }
+    return tasks;
+}
+
+unsigned submit_frame(starpu_data_handle_t mask_handle, unsigned rows, unsigned cols,
+                      const struct viewport *view, int iter) {
+    return submit_tiles(mask_handle, rows, cols, view, iter, 0, 0, 0, 0);
+}
+
+/*
+ * Number of tiles in flight at once in the out-of-core renderer. Bounds both the
+ * StarPU resources (handles, tasks) and the working set of dirty file pages while
+ * still giving every worker a deep queue.
+ */
+#define MBT_WAVE 256
+
+/**
+ * @brief Renders one frame straight into a memory-mapped tiled `.mbt` file.
+ *
+ * Out-of-core path for frames too large to hold in memory: the output file is
+ * grown to its final size and mapped, and every tile is registered as a matrix
+ * handle pointing directly at its slot in the mapping — the tile kernels write
+ * their results straight into the file pages, the kernel writes them back as it
+ * sees fit, and resident memory stays at O(in-flight tiles) regardless of frame
+ * size. No full-frame buffer is ever allocated and no end-of-frame serialization
+ * pass exists. Tiles are processed in waves of `MBT_WAVE` to bound StarPU resource
+ * usage; each tile gets its descriptor, carrying its position in the frame, from
+ * a per-wave arena.
+ *
+ * The renders this path exists for take hours, so every completed wave is
+ * journaled in the header's tile-completion bitmap: when the output file already
+ * holds a matching header (same dimensions, budget and viewport), rendering
+ * resumes after the journaled tiles instead of starting over, and a preempted
+ * 90%-complete render costs 10% to finish rather than 100%. Bits are set only
+ * after the wave's tasks have completed and flushed to the mapping, so a crash
+ * at any point loses at most the in-flight wave.
+ *
+ * @param path The `.mbt` file to create, overwrite, or resume.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ * @return int Returns 0 on success, or -1 if the file cannot be created or mapped.
+ */
+int render_frame_mbt(const char *path, unsigned rows, unsigned cols,
+                     const struct viewport *view, int iter) {
+    unsigned tiles_y = (rows + TILE_ROWS - 1) / TILE_ROWS;
+    unsigned tiles_x = (cols + TILE_COLS - 1) / TILE_COLS;
+    unsigned ntiles = tiles_y * tiles_x;
+    size_t tile_bytes = (size_t)TILE_ROWS * TILE_COLS * sizeof(uint32_t);
+    size_t bitmap_bytes = ((size_t)ntiles + 7) / 8;
+    size_t data_off = (sizeof(struct mbt_header) + bitmap_bytes + MBT_HEADER_SIZE - 1) &
+                      ~((size_t)MBT_HEADER_SIZE - 1);
+    size_t total = data_off + (size_t)ntiles * tile_bytes;
+
+    // The header a finished or in-progress render of this exact frame would carry;
+    // zero-initialized so the padding compares deterministically.
+    struct mbt_header want;
+    memset(&want, 0, sizeof(want));
+    memcpy(want.magic, MBT_MAGIC, sizeof(want.magic));
+    want.rows = rows;
+    want.cols = cols;
+    want.tile_rows = TILE_ROWS;
+    want.tile_cols = TILE_COLS;
+    want.iter = (uint32_t)iter;
+    want.data_off = (uint32_t)data_off;
+    // The mode flags change what the tile payload means, so resuming a render
+    // started with different ones would mix incompatible tiles; the header
+    // comparison below treats any flag difference as a fresh render.
+    want.flags = (smooth_mode ? MBT_FLAG_SMOOTH : 0) |
+                 (ssaa_mode ? MBT_FLAG_SSAA : 0) |
+                 (active_cl == &cl_adaptive ? MBT_FLAG_ADAPTIVE : 0);
+    want.real_start = view->real_start;
+    want.imag_start = view->imag_start;
+    want.real_step = view->real_step;
+    want.imag_step = view->imag_step;
+
+    // No O_TRUNC: an existing file with a matching header is an interrupted
+    // render of this very frame, and its journaled tiles are kept.
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct mbt_header have;
+    int resume = read(fd, &have, sizeof(have)) == (ssize_t)sizeof(have) &&
+                 memcmp(&have, &want, sizeof(want)) == 0 &&
+                 lseek(fd, 0, SEEK_END) == (off_t)total;
+    if ((!resume && ftruncate(fd, 0) < 0) || ftruncate(fd, (off_t)total) < 0) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    unsigned char *map = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+
+    struct mbt_header *hdr = (struct mbt_header *)map;
+    unsigned char *done = map + sizeof(struct mbt_header);
+    if (!resume) {
+        *hdr = want; // the bitmap behind it is zero from the truncation
+    }
+
+    // Frame-wide argument template; per-tile descriptors add the tile's position.
+    struct tile_args tpl = { .view = *view, .iter = iter, .ssaa = ssaa_mode,
+                             .smooth = smooth_mode };
+    struct starpu_codelet *codelet = frame_codelet(view);
+    if (codelet == &cl_f80 && prepare_reference(view, rows, cols, iter, &tpl) == 0) {
+        codelet = &cl_perturb;
+    }
+
+    static struct tile_args wave_args[MBT_WAVE];
+    starpu_data_handle_t wave_handles[MBT_WAVE];
+    unsigned wave_tiles[MBT_WAVE];
+    for (unsigned base = 0; base < ntiles; base += MBT_WAVE) {
+        unsigned wave = ntiles - base < MBT_WAVE ? ntiles - base : MBT_WAVE;
+        unsigned nsub = 0;
+        for (unsigned w = 0; w < wave; w++) {
+            unsigned t = base + w;
+            if (done[t >> 3] & (1u << (t & 7))) {
+                continue; // journaled by the interrupted render, results on disk
+            }
+            unsigned ty = t / tiles_x;
+            unsigned tx = t % tiles_x;
+            unsigned ny = rows - ty * TILE_ROWS < TILE_ROWS ? rows - ty * TILE_ROWS : TILE_ROWS;
+            unsigned nx = cols - tx * TILE_COLS < TILE_COLS ? cols - tx * TILE_COLS : TILE_COLS;
+            uint32_t *slot = (uint32_t *)(map + data_off + (size_t)t * tile_bytes);
+
+            starpu_matrix_data_register(&wave_handles[nsub], STARPU_MAIN_RAM, (uintptr_t)slot,
+                                        TILE_COLS, nx, ny, sizeof(uint32_t));
+            wave_args[nsub] = tpl;
+            wave_args[nsub].row0 = ty * TILE_ROWS;
+            wave_args[nsub].col0 = tx * TILE_COLS;
+            if (codelet == &cl_perturb) {
+                starpu_task_insert(codelet,
+                                   STARPU_W, wave_handles[nsub],
+                                   STARPU_R, ref_orbit.handle,
+                                   STARPU_CL_ARGS_NFREE, &wave_args[nsub], sizeof(wave_args[nsub]),
+                                   0);
+            } else {
+                starpu_task_insert(codelet,
+                                   STARPU_W, wave_handles[nsub],
+                                   STARPU_CL_ARGS_NFREE, &wave_args[nsub], sizeof(wave_args[nsub]),
+                                   0);
+            }
+            wave_tiles[nsub++] = t;
+        }
+        if (nsub == 0) {
+            continue; // whole wave already journaled
+        }
+        starpu_task_wait_for_all();
+        // Unregistering flushes each tile's results to its mapped slot.
+        for (unsigned w = 0; w < nsub; w++) {
+            starpu_data_unregister(wave_handles[w]);
+        }
+        /*
+         * Journal the wave: the bits are set only after the results reached the
+         * mapping, so a killed process never journals unwritten tiles. The async
+         * msync nudges the journal page toward disk without serializing the
+         * render on it; a machine-level crash can at worst lose pages the
+         * journal claims, which a paranoid operator avoids with MS_SYNC.
+         */
+        for (unsigned w = 0; w < nsub; w++) {
+            unsigned t = wave_tiles[w];
+            done[t >> 3] |= (unsigned char)(1u << (t & 7));
+        }
+        msync(map, data_off, MS_ASYNC);
+    }
+
+    int ret = 0;
+    if (munmap(map, total) < 0 || close(fd) < 0) {
+        perror(path);
+        ret = -1;
+    }
+    return ret;
+}
+
+/**
+ * @brief Waits for the submitted tile tasks and brings the results home.
+ *
+ * Completes a frame started with `submit_frame`: waits for all tasks, then
+ * unpartitions the mask handle so the results are coherent in main memory.
+ *
+ * @param mask_handle The registered handle of the escape-time surface.
+ */
+void finish_frame(starpu_data_handle_t mask_handle) {
+    starpu_task_wait_for_all();
+    starpu_data_unpartition(mask_handle, STARPU_MAIN_RAM);
+}
+
+/**
+ * @brief Renders one frame into the registered mask and brings the results home.
+ *
+ * Convenience wrapper pairing `submit_frame` with `finish_frame`. StarPU itself stays
+ * up between calls: rendering many frames pays the initialization (topology discovery,
+ * worker thread spawn) exactly once.
+ *
+ * @param mask_handle The registered handle of the escape-time surface.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ */
+void render_frame(starpu_data_handle_t mask_handle, unsigned rows, unsigned cols,
+                  const struct viewport *view, int iter) {
+    submit_frame(mask_handle, rows, cols, view, iter);
+    finish_frame(mask_handle);
+}
+
+/**
+ * @brief Renders a frame, reusing the previous frame's pixels when the viewport only panned.
+ *
+ * When the new viewport has the same per-pixel steps, grid size and iteration budget as
+ * the cached frame and is offset from it by a whole number of pixels, the surviving
+ * region is translated into the new mask with row memcpys and tile tasks are submitted
+ * only for the tiles touching newly exposed pixels — pan latency becomes proportional
+ * to the exposed border instead of the full frame. Any other change (zoom, resolution,
+ * budget, or a non-integral offset) falls back to a full render. The completed frame is
+ * snapshotted into the cache either way.
+ *
+ * @param mask_handle The registered handle of the escape-time surface.
+ * @param mask The buffer the handle was registered with.
+ * @param rows The number of rows of the grid.
+ * @param cols The number of columns of the grid.
+ * @param view The viewport describing the frame.
+ * @param iter The maximum number of iterations per point.
+ */
+void render_frame_pan(starpu_data_handle_t mask_handle, uint32_t *mask,
+                      unsigned rows, unsigned cols, const struct viewport *view, int iter) {
+    long dx = 0, dy = 0;
+    int reusable = pan_cache.valid && pan_cache.rows == rows && pan_cache.cols == cols &&
+                   pan_cache.iter == iter && pan_cache.view.real_step == view->real_step &&
+                   pan_cache.view.imag_step == view->imag_step;
+    if (reusable) {
+        // The offset must land on the pixel grid for the old samples to be reusable.
+        double dxd = (view->real_start - pan_cache.view.real_start) / view->real_step;
+        double dyd = (view->imag_start - pan_cache.view.imag_start) / view->imag_step;
+        dx = lround(dxd);
+        dy = lround(dyd);
+        reusable = fabs(dxd - dx) < 1e-6 && fabs(dyd - dy) < 1e-6;
+    }
+
+    // Region of the new frame whose pixels survive from the cached one.
+    unsigned r0 = 0, r1 = 0, c0 = 0, c1 = 0;
+    if (reusable) {
+        r0 = dy < 0 ? (unsigned)-dy : 0;
+        r1 = dy > 0 ? (dy < (long)rows ? rows - (unsigned)dy : 0) : rows;
+        c0 = dx < 0 ? (unsigned)-dx : 0;
+        c1 = dx > 0 ? (dx < (long)cols ? cols - (unsigned)dx : 0) : cols;
+        reusable = r0 < r1 && c0 < c1;
+    }
+
+    if (reusable) {
+        starpu_data_acquire(mask_handle, STARPU_W);
+        for (unsigned r = r0; r < r1; r++) {
+            memcpy(&mask[(size_t)r * cols + c0],
+                   &pan_cache.mask[(size_t)(r + dy) * cols + c0 + dx],
+                   (size_t)(c1 - c0) * sizeof(uint32_t));
+        }
+        starpu_data_release(mask_handle);
+        submit_tiles(mask_handle, rows, cols, view, iter, r0, r1, c0, c1);
+        finish_frame(mask_handle);
+    } else {
+        render_frame(mask_handle, rows, cols, view, iter);
+    }
+
+    size_t size = (size_t)rows * cols * sizeof(uint32_t);
+    if (pan_cache.mask != NULL && pan_cache.size != size) {
+        mb_free(pan_cache.mask, pan_cache.size);
+        pan_cache.mask = NULL;
+        pan_cache.valid = 0;
+    }
+    if (pan_cache.mask == NULL) {
+        pan_cache.size = size;
+        pan_cache.mask = mb_alloc(size);
+        if (pan_cache.mask == NULL) {
+            return; // No cache: every frame renders in full.
+        }
+    }
+    memcpy(pan_cache.mask, mask, size);
+    pan_cache.view = *view;
+    pan_cache.iter = iter;
+    pan_cache.rows = rows;
+    pan_cache.cols = cols;
+    pan_cache.valid = 1;
+}
+
+/**
+ * @brief Releases the pan cache. Must be called before `starpu_shutdown`.
+ */
+void pan_cache_drop(void) {
+    if (pan_cache.mask != NULL) {
+        mb_free(pan_cache.mask, pan_cache.size);
+        pan_cache.mask = NULL;
+    }
+    pan_cache.valid = 0;
+    free(tile_prio.cost);
+    free(tile_prio.prio);
+    tile_prio.cost = NULL;
+    tile_prio.prio = NULL;
+    tile_prio.cap = 0;
+}
+
+/**
+ * @brief Builds the output file name of one animation frame.
+ *
+ * The frame number is inserted before the file extension (`zoom.pgm` becomes
+ * `zoom-000042.pgm`), or appended when the output name has no extension. For
+ * single-frame renders the output name is used untouched.
+ *
+ * @param buf The buffer receiving the file name.
+ * @param len The size of `buf`.
+ * @param output The output name given on the command line.
+ * @param frames The total number of frames being rendered.
+ * @param frame The current frame number, starting at 0.
+ */
+void frame_path(char *buf, size_t len, const char *output, unsigned frames, unsigned frame) {
+    if (frames == 1) {
+        snprintf(buf, len, "%s", output);
+        return;
+    }
+    const char *ext = strrchr(output, '.');
+    if (ext == NULL) {
+        snprintf(buf, len, "%s-%06u", output, frame);
+    } else {
+        snprintf(buf, len, "%.*s-%06u%s", (int)(ext - output), output, frame, ext);
+    }
+}